@@ -0,0 +1,309 @@
+#include "asset_loader.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+
+#include "shader.hpp"
+
+static double now_ms()
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool asset_loader::create(size_t budget)
+{
+  frame_budget = budget;
+  started      = now_ms();
+  s3tc         = has_gl_extension("GL_EXT_texture_compression_s3tc");
+
+  if(!staging.create(frame_budget))
+  {
+    fprintf(stderr, "ERROR: failed to create texture staging buffer\n");
+    return false;
+  }
+
+  return true;
+}
+
+// drops the cpu side copy, decoded pixels or the mapping
+static void release_source(asset_loader::texture_asset& a)
+{
+  if(a.img.data)
+    Image_free(&a.img);
+  a.img.data = nullptr;
+
+  a.encoded.clear();
+  a.encoded.shrink_to_fit();
+
+  a.file.close();
+  a.levels.clear();
+}
+
+void asset_loader::destroy()
+{
+  //decode jobs write into the records, let them finish first
+  jobs.wait(&decoding);
+
+  for(texture_asset& a : textures)
+  {
+    release_source(a);
+    glDeleteTextures(1, &a.texture);
+  }
+
+  textures.clear();
+  staging.destroy();
+}
+
+// a cooked container older than its source is stale and ignored
+static bool cooked_is_fresh(const std::string& source, const std::string& cooked)
+{
+  struct stat src, out;
+  if(stat(cooked.c_str(), &out) != 0)
+    return false;
+
+  return stat(source.c_str(), &src) != 0 || out.st_mtime >= src.st_mtime;
+}
+
+static void decode_job(void* data, size_t, size_t)
+{
+  asset_loader::texture_asset& a = *(asset_loader::texture_asset*)data;
+  asset_loader& loader = *a.loader;
+
+  std::string cooked = a.path + ".gtex";
+
+  if(cooked_is_fresh(a.path, cooked) && a.file.open(cooked))
+  {
+    //a bc1 container without driver support falls back to the source
+    if(a.file.header->format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT && !loader.s3tc)
+      a.file.close();
+  }
+
+  if(a.file.base)
+  {
+    a.format = a.file.header->format;
+
+    for(uint32_t i = 0; i < a.file.header->levels; ++i)
+    {
+      const texture_level& l = a.file.levels[i];
+      a.levels.push_back({a.file.level_data(i), (int)l.width, (int)l.height, l.row_bytes, (int)l.rows});
+    }
+
+    loader.cooked.fetch_add(1, std::memory_order_relaxed);
+    a.state.store(asset_loader::DECODED, std::memory_order_release);
+    return;
+  }
+
+  Image_load(&a.img, a.path.c_str());
+
+  if(!a.img.data)
+  {
+    fprintf(stderr, "ERROR: failed to load %s\n", a.path.c_str());
+    a.state.store(asset_loader::FAILED, std::memory_order_release);
+    return;
+  }
+
+  a.format = GL_RGBA8;
+  int w = a.img.w, h = a.img.h;
+
+  if(loader.compress)
+  {
+    a.format = pick_block_format(a.img.data, a.img.w, a.img.h);
+    if(a.format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT && !loader.s3tc)
+      a.format = GL_COMPRESSED_RGBA_BPTC_UNORM;
+  }
+
+  //block formats can not be mipmapped by the driver, they always get
+  //their chain here
+  a.generate_mips = loader.gpu_mips && a.format == GL_RGBA8;
+
+  if(!a.generate_mips)
+  {
+    encode_levels(a.img.data, a.img.w, a.img.h, true, a.format, loader.compress_quality, a.encoded);
+    Image_free(&a.img);
+    a.img.data = nullptr;
+  }
+
+  for(size_t i = 0; i < (a.encoded.empty() ? 1 : a.encoded.size()); ++i)
+  {
+    uint32_t row_bytes, rows;
+    texture_level_layout(a.format, w, h, row_bytes, rows);
+    a.levels.push_back({a.encoded.empty() ? a.img.data : a.encoded[i].data(), w, h, row_bytes, (int)rows});
+
+    w = w > 1 ? w / 2 : 1;
+    h = h > 1 ? h / 2 : 1;
+  }
+
+  a.state.store(asset_loader::DECODED, std::memory_order_release);
+}
+
+int asset_loader::load_texture(const std::string& path, GLenum filter, GLenum wrap)
+{
+  textures.emplace_back();
+  texture_asset& a = textures.back();
+  a.loader = this;
+  a.path   = path;
+  a.filter = filter;
+  a.wrap   = wrap;
+
+  //inline when the job system is not running or has no workers
+  jobs.run(decode_job, &a, 0, 1, &decoding);
+
+  return (int)textures.size() - 1;
+}
+
+// rows [rows_uploaded, rows_uploaded + rows) of the current level, from
+// the bound unpack buffer or client memory. block rows cover 4 pixel rows,
+// the last one is clipped to the level
+static void upload_rows(const asset_loader::texture_asset& a, const asset_loader::level_source& l, size_t rows, const void* src)
+{
+  if(a.format == GL_RGBA8)
+  {
+    glTextureSubImage2D(a.texture, a.level, 0, a.rows_uploaded, l.width, (GLsizei)rows, GL_RGBA, GL_UNSIGNED_BYTE, src);
+    return;
+  }
+
+  int block = texture_block_height(a.format);
+  int y     = a.rows_uploaded * block;
+  int h     = (int)rows * block < l.height - y ? (int)rows * block : l.height - y;
+
+  glCompressedTextureSubImage2D(a.texture, a.level, 0, y, l.width, h, a.format, (GLsizei)(rows * l.row_bytes), src);
+}
+
+// copies as many whole rows as fit in the budget into the staging ring
+// and uploads them from there, level by level. returns true once the
+// texture is complete.
+bool asset_loader::upload(texture_asset& a, size_t& budget)
+{
+  if(!a.texture)
+  {
+    //mip chains sample from their levels, single images keep the filter
+    GLenum min_filter = a.filter;
+    if(a.levels.size() > 1)
+      min_filter = a.filter == GL_NEAREST ? GL_NEAREST_MIPMAP_NEAREST : GL_LINEAR_MIPMAP_LINEAR;
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &a.texture);
+    glTextureParameteri(a.texture, GL_TEXTURE_WRAP_S, a.wrap);
+    glTextureParameteri(a.texture, GL_TEXTURE_WRAP_T, a.wrap);
+    glTextureParameteri(a.texture, GL_TEXTURE_MIN_FILTER, min_filter);
+    glTextureParameteri(a.texture, GL_TEXTURE_MAG_FILTER, a.filter);
+    a.storage_levels = (int)a.levels.size();
+    if(a.generate_mips)
+      for(int size = a.levels[0].width > a.levels[0].height ? a.levels[0].width : a.levels[0].height; size > 1; size /= 2)
+        ++a.storage_levels;
+
+    glTextureStorage2D(a.texture, a.storage_levels, a.format, a.levels[0].width, a.levels[0].height);
+  }
+
+  while(a.level < (int)a.levels.size())
+  {
+    const level_source& l = a.levels[a.level];
+
+    size_t remaining = l.rows - a.rows_uploaded;
+    size_t rows      = budget / l.row_bytes < remaining ? budget / l.row_bytes : remaining;
+    const unsigned char* src = l.data + (size_t)a.rows_uploaded * l.row_bytes;
+
+    if(rows > 0)
+    {
+      //budget and the staging region shrink together, so this always fits
+      void* ptr = nullptr;
+      size_t offset = staging.alloc(rows * l.row_bytes, 4, &ptr);
+
+      memcpy(ptr, src, rows * l.row_bytes);
+      upload_rows(a, l, rows, (const void*)offset);
+
+      budget -= rows * l.row_bytes;
+    } else if(budget == frame_budget) {
+      //a single row larger than the whole ring goes straight from memory
+      rows = 1;
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      upload_rows(a, l, 1, src);
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.id);
+
+      budget = 0;
+    } else {
+      return false; //next frame
+    }
+
+    a.rows_uploaded += (int)rows;
+    uploaded_bytes  += rows * l.row_bytes;
+
+    if(a.rows_uploaded < l.rows)
+      return false;
+
+    ++a.level;
+    a.rows_uploaded = 0;
+  }
+
+  //the fallback: an srgb view of the same storage makes the driver
+  //filter in linear light, the levels land in the rgba8 texture
+  if(a.generate_mips)
+  {
+    unsigned int view = 0;
+    glGenTextures(1, &view);
+    glTextureView(view, GL_TEXTURE_2D, a.texture, GL_SRGB8_ALPHA8, 0, a.storage_levels, 0, 1);
+    glGenerateTextureMipmap(view);
+    glDeleteTextures(1, &view);
+  }
+
+  return true;
+}
+
+int asset_loader::update()
+{
+  int pending = 0;
+  size_t budget = frame_budget;
+  bool bound = false;
+
+  for(texture_asset& a : textures)
+  {
+    int s = a.state.load(std::memory_order_acquire);
+
+    if(s == DECODED && budget > 0)
+    {
+      if(!bound)
+      {
+        staging.begin_frame();
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.id);
+        bound = true;
+      }
+
+      if(upload(a, budget))
+      {
+        release_source(a);
+        a.state.store(READY, std::memory_order_relaxed);
+        s = READY;
+      }
+    }
+
+    pending += s == DECODING || s == DECODED;
+  }
+
+  if(bound)
+  {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    staging.end_frame();
+    ++upload_frames;
+  }
+
+  if(!pending && !reported && !textures.empty())
+  {
+    fprintf(stderr, "assets: %zu textures (%d cooked), %.1f MB uploaded over %d frames, ready after %.1f ms\n",
+            textures.size(), cooked.load(), uploaded_bytes / (1024.0 * 1024.0), upload_frames, now_ms() - started);
+    reported = true;
+  }
+
+  return pending;
+}
+
+unsigned int asset_loader::texture(int handle) const
+{
+  const texture_asset& a = textures[handle];
+  return a.state.load(std::memory_order_acquire) == READY ? a.texture : 0;
+}
+
+asset_loader::state_t asset_loader::state(int handle) const
+{
+  return (state_t)textures[handle].state.load(std::memory_order_acquire);
+}
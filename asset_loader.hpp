@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+#include <glad/gl.h>
+
+#include "jobs.hpp"
+#include "stream_buffer.hpp"
+#include "texture_file.hpp"
+
+extern "C" {
+  #include <image.h>
+}
+
+// textures decoded on the job system and uploaded by the render thread.
+// load_texture() returns a handle right away, workers map a cooked
+// `<path>.gtex` container when one is at least as new as the source and
+// decode the file otherwise,
+// update() copies decoded rows into a persistently mapped pixel unpack ring
+// and issues glTextureSubImage2D from it, at most `frame_budget` bytes per
+// frame, so a large asset set streams in over several frames instead of
+// stalling one. the cpu copy is freed once the last row is uploaded.
+//
+// decoded images get a gamma-correct mip chain on the worker (or from the
+// driver with `gpu_mips`). with `compress` set they are also block
+// compressed there (bc1 when opaque and s3tc is available, bc7 otherwise).
+struct asset_loader
+{
+  enum state_t
+  {
+    DECODING,
+    DECODED,
+    READY,
+    FAILED,
+  };
+
+  // one mip level as the upload sees it, pointing into the decoded
+  // image or the mapped container
+  struct level_source
+  {
+    const unsigned char* data;
+    int                  width, height;
+    size_t               row_bytes;
+    int                  rows;      //pixel rows or rows of 4x4 blocks
+  };
+
+  struct texture_asset
+  {
+    asset_loader*        loader  = nullptr;
+    std::string          path;
+    GLenum               filter  = GL_NEAREST;
+    GLenum               wrap    = GL_REPEAT;
+    Image                img     = {};
+    texture_file         file;
+    std::vector<std::vector<unsigned char>> encoded; //compressed at load time
+    GLenum               format  = GL_RGBA8;
+    std::vector<level_source> levels;
+    std::atomic<int>     state{DECODING};
+    unsigned int         texture = 0;
+    int                  level   = 0; //being uploaded
+    bool                 generate_mips = false; //by the driver, after level 0
+    int                  storage_levels = 0;
+    int                  rows_uploaded = 0;
+  };
+
+  bool create(size_t frame_budget = 4 << 20);
+  void destroy();
+
+  int load_texture(const std::string& path, GLenum filter = GL_NEAREST, GLenum wrap = GL_REPEAT);
+
+  // uploads within the budget, call once per frame on the render thread.
+  // returns how many textures are not ready yet
+  int update();
+
+  // 0 until every row is on the gpu
+  unsigned int texture(int handle) const;
+  state_t      state(int handle) const;
+
+  bool upload(texture_asset& a, size_t& budget);
+
+  std::deque<texture_asset> textures; //stable addresses for the decode jobs
+  job_counter               decoding;
+  stream_buffer             staging;
+  size_t                    frame_budget = 0;
+
+  bool       compress = false;
+  bool       gpu_mips = false; //mip uncompressed images on the gpu instead of the workers
+  bc_quality compress_quality = BC_FAST;
+  bool       s3tc     = false; //bc1 needs EXT_texture_compression_s3tc, bc7 is core
+
+  //reported once everything is in
+  std::atomic<int> cooked{0};
+  size_t uploaded_bytes = 0;
+  int    upload_frames  = 0;
+  double started        = 0;
+  bool   reported       = false;
+};
@@ -0,0 +1,129 @@
+// block compression throughput in megapixels per second for every
+// format and preset, with the psnr of the decoded result.
+//
+//   g++ -std=c++17 -O2 -march=native -pthread -I. bench/bc_bench.cpp texture_compress.cpp jobs.cpp -o bc_bench
+//   ./bc_bench [size] [--single-thread]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "jobs.hpp"
+#include "texture_compress.hpp"
+
+//smooth colour gradients with grain and soft edged discs in alpha, about
+//what painted sprites look like
+static std::vector<uint8_t> make_image(int size, bool alpha)
+{
+  std::vector<uint8_t> img((size_t)size * size * 4);
+  unsigned rng = 12345;
+
+  for(int y = 0; y < size; ++y)
+    for(int x = 0; x < size; ++x)
+    {
+      rng = rng * 1664525u + 1013904223u;
+      int grain = (int)(rng >> 29) - 4;
+
+      float fx = x / (float)size, fy = y / (float)size;
+      uint8_t* p = &img[((size_t)y * size + x) * 4];
+
+      p[0] = (uint8_t)fminf(fmaxf(128 + 127 * sinf(fx * 9.f) + grain, 0), 255);
+      p[1] = (uint8_t)fminf(fmaxf(128 + 127 * cosf(fy * 7.f + fx * 3.f) + grain, 0), 255);
+      p[2] = (uint8_t)fminf(fmaxf(255 * fx * fy + grain, 0), 255);
+
+      float cx = fmodf(x, 64.f) - 32.f, cy = fmodf(y, 64.f) - 32.f;
+      float d  = sqrtf(cx * cx + cy * cy);
+      p[3] = alpha ? (uint8_t)fminf(fmaxf((28.f - d) * 32.f, 0), 255) : 255;
+    }
+
+  return img;
+}
+
+static double psnr(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, int channels)
+{
+  double err = 0;
+  for(size_t i = 0; i < a.size(); ++i)
+    if((int)(i % 4) < channels)
+    {
+      double d = (double)a[i] - b[i];
+      err += d * d;
+    }
+
+  double mse = err / (a.size() / 4 * channels);
+  return mse > 0 ? 10 * log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+static std::vector<uint8_t> decode(const std::vector<uint8_t>& blocks, int size, size_t block_bytes)
+{
+  std::vector<uint8_t> img((size_t)size * size * 4);
+  int n = size / 4;
+  uint8_t block[64];
+
+  for(int by = 0; by < n; ++by)
+    for(int bx = 0; bx < n; ++bx)
+    {
+      const uint8_t* in = &blocks[((size_t)by * n + bx) * block_bytes];
+      if(block_bytes == 8)
+        decode_bc1_block(in, block);
+      else
+        decode_bc7_block(in, block);
+
+      for(int y = 0; y < 4; ++y)
+        memcpy(&img[(((size_t)by * 4 + y) * size + bx * 4) * 4], block + y * 16, 16);
+    }
+
+  return img;
+}
+
+int main(int argc, char* argv[])
+{
+  int  size = 1024;
+  bool single_thread = false;
+
+  for(int i = 1; i < argc; ++i)
+  {
+    if(std::string(argv[i]) == "--single-thread")
+      single_thread = true;
+    else
+      size = atoi(argv[i]) & ~3;
+  }
+
+  if(!single_thread)
+    jobs.init();
+
+  std::vector<uint8_t> opaque = make_image(size, false);
+  std::vector<uint8_t> sprite = make_image(size, true);
+
+  const char* names[] = {"fast", "normal", "high"};
+  double mpix = size * (double)size / 1e6;
+
+  printf("%dx%d, %d thread(s)\n", size, size, single_thread ? 1 : jobs.thread_count());
+
+  for(int format = 0; format < 2; ++format)
+  {
+    const std::vector<uint8_t>& src = format == 0 ? opaque : sprite;
+    size_t block_bytes = format == 0 ? 8 : 16;
+    std::vector<uint8_t> out(format == 0 ? bc1_size(size, size) : bc7_size(size, size));
+
+    for(int q = BC_FAST; q <= BC_HIGH; ++q)
+    {
+      auto start = std::chrono::steady_clock::now();
+      if(format == 0)
+        encode_bc1(src.data(), size, size, out.data(), (bc_quality)q);
+      else
+        encode_bc7(src.data(), size, size, out.data(), (bc_quality)q);
+      double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      printf("  %s %-6s  %8.1f MP/s  %6.2f dB\n", format == 0 ? "bc1" : "bc7", names[q], mpix / s,
+             psnr(src, decode(out, size, block_bytes), format == 0 ? 3 : 4));
+    }
+  }
+
+  if(!single_thread)
+    jobs.shutdown();
+  return 0;
+}
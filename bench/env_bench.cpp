@@ -0,0 +1,112 @@
+// headless batched bird games: environment steps per second for the
+// scalar and avx2 kernels, after checking that both play the same games.
+//
+//   g++ -std=c++17 -O2 -march=native -pthread -I. bench/env_bench.cpp bird_env.cpp jobs.cpp -o env_bench
+//   ./env_bench [games] [steps]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "bird_env.hpp"
+#include "jobs.hpp"
+
+struct buffers
+{
+  std::vector<float>   obs, rewards;
+  std::vector<uint8_t> dones;
+
+  explicit buffers(size_t n) : obs(n * bird_env_batch::obs_size), rewards(n), dones(n) {}
+};
+
+//random flaps, a few frames apart like a (bad) player
+static std::vector<std::vector<uint8_t>> make_actions(size_t games, int variants)
+{
+  std::mt19937 rng(1);
+  std::vector<std::vector<uint8_t>> actions(variants, std::vector<uint8_t>(games));
+  for(auto& a : actions)
+    for(auto& v : a)
+      v = rng() % 12 == 0;
+  return actions;
+}
+
+static bool check(size_t games)
+{
+  bird_env_batch simd, scalar;
+  simd.create(games, 42);
+  scalar.create(games, 42);
+  scalar.simd = false;
+
+  buffers a(games), b(games);
+  simd.reset(a.obs.data());
+  scalar.reset(b.obs.data());
+
+  auto actions = make_actions(games, 16);
+  size_t mismatched = 0, dones = 0;
+
+  for(int s = 0; s < 600; ++s)
+  {
+    const uint8_t* act = actions[s % actions.size()].data();
+    simd.step(act, a.obs.data(), a.rewards.data(), a.dones.data());
+    scalar.step(act, b.obs.data(), b.rewards.data(), b.dones.data());
+
+    for(size_t i = 0; i < games; ++i)
+    {
+      dones += a.dones[i];
+      bool same = a.dones[i] == b.dones[i] && a.rewards[i] == b.rewards[i];
+      for(int k = 0; k < bird_env_batch::obs_size; ++k)
+        same = same && std::fabs(a.obs[i * 4 + k] - b.obs[i * 4 + k]) < 1e-4f;
+      mismatched += !same;
+    }
+  }
+
+  printf("check: %zu game steps, %zu episodes ended, %zu steps differ between kernels\n",
+         games * 600, dones, mismatched);
+  return mismatched == 0;
+}
+
+static double run(bird_env_batch& env, buffers& buf, const std::vector<std::vector<uint8_t>>& actions, int steps)
+{
+  env.reset(buf.obs.data());
+
+  auto start = std::chrono::steady_clock::now();
+  for(int s = 0; s < steps; ++s)
+    env.step(actions[s % actions.size()].data(), buf.obs.data(), buf.rewards.data(), buf.dones.data());
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  return env.size() * (double)steps / sec;
+}
+
+int main(int argc, char* argv[])
+{
+  size_t games = argc > 1 ? strtoul(argv[1], nullptr, 10) : 16384;
+  int    steps = argc > 2 ? atoi(argv[2]) : 1000;
+
+  jobs.init();
+
+  if(!check(4096))
+  {
+    fprintf(stderr, "ERROR: scalar and avx2 kernels disagree\n");
+    return 1;
+  }
+
+  auto actions = make_actions(games, 16);
+  buffers buf(games);
+  bird_env_batch env;
+  env.create(games, 7);
+
+  env.simd = false;
+  double scalar = run(env, buf, actions, steps);
+  env.simd = true;
+  double simd = run(env, buf, actions, steps);
+
+  printf("%zu games x %d steps on %d threads\n", games, steps, jobs.thread_count());
+  printf("scalar  %8.1f M steps/s\n", scalar / 1e6);
+  printf("avx2    %8.1f M steps/s\n", simd / 1e6);
+
+  jobs.shutdown();
+  return 0;
+}
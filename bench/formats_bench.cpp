@@ -0,0 +1,126 @@
+// cpu side cost of the sprite instance formats: packing from the sprite
+// store plus the copy into a (simulated) mapped upload buffer.
+// --check-half instead compares the f16c half conversions with the
+// scalar fallback for every float and every half, bit for bit.
+//
+//   g++ -std=c++17 -O2 -march=native -pthread -I. bench/formats_bench.cpp sprites.cpp jobs.cpp -o formats_bench
+//   ./formats_bench [sprites]
+//   ./formats_bench --check-half
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "jobs.hpp"
+#include "quantize.hpp"
+#include "sprites.hpp"
+
+// the layout the renderer used before the compact one
+struct float_instance
+{
+  float x, y;
+  float sx, sy;
+  float u_offset;
+  float texture;
+  float layer;
+  float pad;
+};
+
+static void pack_float(const sprite_store& s, float_instance* out)
+{
+  for(size_t i = 0; i < s.size(); ++i)
+  {
+    float_instance& o = out[i];
+    o.x = s.pos_x[i];   o.y = s.pos_y[i];
+    o.sx = s.scale_x[i]; o.sy = s.scale_y[i];
+    o.u_offset = s.frame[i] * (1.f / sprite_frames);
+    o.texture = s.texture[i];
+    o.layer = s.layer[i];
+    o.pad = 0;
+  }
+}
+
+template <typename F>
+static double time_ms(int reps, const F& f)
+{
+  f();
+  auto start = std::chrono::steady_clock::now();
+  for(int i = 0; i < reps; ++i)
+    f();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / reps;
+}
+
+// every one of the 2^32 float inputs and 2^16 half inputs, nans included
+static bool check_half()
+{
+#if defined(__F16C__)
+  size_t to_bad = 0, from_bad = 0;
+
+  for(uint64_t i = 0; i < (1ull << 32); ++i)
+  {
+    uint32_t x = (uint32_t)i;
+    float f;
+    memcpy(&f, &x, 4);
+
+    if(to_half(f) != to_half_scalar(f) && to_bad++ == 0)
+      fprintf(stderr, "ERROR: to_half(0x%08x) f16c 0x%04x, scalar 0x%04x\n", x, to_half(f), to_half_scalar(f));
+  }
+
+  for(uint32_t h = 0; h < 65536; ++h)
+  {
+    float a = from_half((uint16_t)h), b = from_half_scalar((uint16_t)h);
+
+    if(memcmp(&a, &b, 4) != 0 && from_bad++ == 0)
+      fprintf(stderr, "ERROR: from_half(0x%04x) differs between f16c and scalar\n", h);
+  }
+
+  printf("to_half: %zu of 2^32 differ, from_half: %zu of 2^16 differ\n", to_bad, from_bad);
+  return to_bad == 0 && from_bad == 0;
+#else
+  fprintf(stderr, "ERROR: built without f16c, nothing to compare against\n");
+  return false;
+#endif
+}
+
+int main(int argc, char* argv[])
+{
+  if(argc > 1 && strcmp(argv[1], "--check-half") == 0)
+    return check_half() ? 0 : 1;
+
+  size_t n = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+
+  //single threaded so the numbers reflect bytes moved, not core count
+  jobs.init(0);
+
+  sprite_store s;
+  s.reserve(n);
+  for(size_t i = 0; i < n; ++i)
+  {
+    sprite_desc d;
+    d.x = (float)(i % 1000); d.y = (float)(i / 1000);
+    d.sx = d.sy = 0.1f;
+    d.frame = i & 1;
+    s.create(d);
+  }
+
+  std::vector<float_instance>  f32(n);
+  std::vector<sprite_instance> packed(n);
+  std::vector<unsigned char>   upload(n * sizeof(float_instance));
+
+  double f_pack = time_ms(20, [&] { pack_float(s, f32.data()); });
+  double c_pack = time_ms(20, [&] { sprites_pack_instances(s, packed.data()); });
+  double f_copy = time_ms(20, [&] { memcpy(upload.data(), f32.data(), n * sizeof(float_instance)); });
+  double c_copy = time_ms(20, [&] { memcpy(upload.data(), packed.data(), n * sizeof(sprite_instance)); });
+
+  printf("%zu sprites\n", n);
+  printf("format      bytes/inst  MB/frame  pack ms  upload copy ms\n");
+  printf("float       %10zu %9.2f %8.3f %15.3f\n", sizeof(float_instance), n * sizeof(float_instance) / 1e6, f_pack, f_copy);
+  printf("compact     %10zu %9.2f %8.3f %15.3f\n", sizeof(sprite_instance), n * sizeof(sprite_instance) / 1e6, c_pack, c_copy);
+  printf("bandwidth ratio %.2fx, copy speedup %.2fx\n",
+         (double)sizeof(float_instance) / sizeof(sprite_instance), f_copy / c_copy);
+
+  jobs.shutdown();
+  return 0;
+}
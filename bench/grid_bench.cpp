@@ -0,0 +1,154 @@
+// uniform grid over sprite positions: build, the incremental per-frame
+// update, rect queries and broadphase against linear scans. the update is
+// checked against a fresh build of the same positions.
+//
+//   g++ -std=c++17 -O2 -march=native -pthread -I. bench/grid_bench.cpp spatial_grid.cpp jobs.cpp -o grid_bench
+//   ./grid_bench [count]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "jobs.hpp"
+#include "spatial_grid.hpp"
+
+template <typename F>
+static double time_ms(int reps, const F& f)
+{
+  double best = 1e30;
+  for(int i = 0; i < reps; ++i)
+  {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    best = ms < best ? ms : best;
+  }
+  return best;
+}
+
+int main(int argc, char* argv[])
+{
+  size_t count = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+  const float world = 100.f;
+
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<float> pos(-world, world), step(-0.01f, 0.01f);
+
+  std::vector<float> x(count), y(count);
+  for(size_t i = 0; i < count; ++i)
+  {
+    x[i] = pos(rng);
+    y[i] = pos(rng);
+  }
+
+  jobs.init();
+
+  spatial_grid grid;
+  grid.configure(0.5f, -world, -world, world, world);
+
+  double build_ms = time_ms(5, [&] { grid.build(x.data(), y.data(), count); });
+
+  printf("%zu points, %dx%d cells\n", count, grid.cols, grid.rows);
+  printf("build                %8.3f ms\n", build_ms);
+
+  //frames of sprite-like movement, each step moves every point and a few
+  //percent cross into another cell. the update of one frame is timed and
+  //the state rolled forward, so every update sees a fresh frame.
+  std::vector<float> vx(count), vy(count);
+  for(size_t i = 0; i < count; ++i)
+  {
+    vx[i] = step(rng);
+    vy[i] = step(rng);
+  }
+
+  grid.build(x.data(), y.data(), count);
+
+  const int frames = 10;
+  double update_ms = 0, still_ms = 0;
+  size_t moved = 0;
+
+  for(int f = 0; f < frames; ++f)
+  {
+    for(size_t i = 0; i < count; ++i)
+    {
+      x[i] += vx[i];
+      y[i] += vy[i];
+    }
+
+    update_ms += time_ms(1, [&] { grid.update(x.data(), y.data(), count); });
+    moved     += grid.moved;
+  }
+
+  still_ms = time_ms(5, [&] { grid.update(x.data(), y.data(), count); });
+
+  printf("update, no crossings %8.3f ms\n", still_ms);
+  printf("update, moving       %8.3f ms (%zu of %zu points changed cell per frame, %zu rebuilds)\n",
+         update_ms / frames, moved / frames, count, grid.rebuilds);
+
+  //the updated grid has to answer like one built from scratch
+  spatial_grid fresh;
+  fresh.configure(0.5f, -world, -world, world, world);
+  fresh.build(x.data(), y.data(), count);
+
+  bool same = true;
+  std::vector<uint32_t> a, b;
+  for(float cx = -world; cx < world; cx += 17.f)
+  {
+    a.clear();
+    b.clear();
+    grid.query_rect(cx, cx * 0.5f, cx + 6.f, cx * 0.5f + 3.f, a);
+    fresh.query_rect(cx, cx * 0.5f, cx + 6.f, cx * 0.5f + 3.f, b);
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    same &= a == b;
+  }
+
+  same &= grid.pick(1.f, 2.f, 0.3f) == fresh.pick(1.f, 2.f, 0.3f);
+
+  std::vector<collision_pair> pa, pb;
+  grid.broadphase(0.05f, pa);
+  fresh.broadphase(0.05f, pb);
+  auto by_pair = [](const collision_pair& l, const collision_pair& r) { return l.a != r.a ? l.a < r.a : l.b < r.b; };
+  std::sort(pa.begin(), pa.end(), by_pair);
+  std::sort(pb.begin(), pb.end(), by_pair);
+  same &= pa.size() == pb.size() && std::equal(pa.begin(), pa.end(), pb.begin(),
+                                               [](const collision_pair& l, const collision_pair& r) { return l.a == r.a && l.b == r.b; });
+
+  printf("update against build %8s\n", same ? "same" : "DIFFERENT");
+
+  //a view sized rect
+  std::vector<uint32_t> hits;
+  size_t grid_hits = 0, scan_hits = 0;
+
+  double query_ms = time_ms(20, [&] {
+    hits.clear();
+    grid.query_rect(-4, -4, 4, 4, hits);
+    grid_hits = hits.size();
+  });
+
+  double scan_ms = time_ms(20, [&] {
+    hits.clear();
+    for(size_t i = 0; i < count; ++i)
+      if(x[i] >= -4 && x[i] <= 4 && y[i] >= -4 && y[i] <= 4)
+        hits.push_back((uint32_t)i);
+    scan_hits = hits.size();
+  });
+
+  printf("rect query           %8.3f ms (%zu hits), linear scan %.3f ms (%zu hits)\n", query_ms, grid_hits, scan_ms, scan_hits);
+
+  double pick_ms = time_ms(20, [&] { grid.pick(1.f, 2.f, 0.1f); });
+  printf("pick                 %8.4f ms\n", pick_ms);
+
+  std::vector<collision_pair> pairs;
+  double broad_ms = time_ms(3, [&] {
+    pairs.clear();
+    grid.broadphase(0.05f, pairs);
+  });
+  printf("broadphase (d=0.05)  %8.3f ms, %zu pairs\n", broad_ms, pairs.size());
+
+  jobs.shutdown();
+  return grid_hits == scan_hits && same ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+// per-frame sprite work (animation, transforms, culling, instance fill) on
+// the job system with 1..N threads. first checks that run() without
+// workers executes the job before it returns.
+//
+//   g++ -std=c++17 -O2 -march=native -pthread -I. bench/jobs_bench.cpp jobs.cpp -o jobs_bench
+//   ./jobs_bench [sprites] [max threads]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "jobs.hpp"
+
+struct scene
+{
+  std::vector<float> x, y, vx, vy, rot, anim;
+  std::vector<int>   frame;
+  std::vector<float> xform;   //2x3 per sprite
+  std::vector<unsigned char> visible;
+  std::vector<float> instances; //8 floats per visible sprite
+  std::vector<size_t> chunk_counts;
+};
+
+static void make_scene(scene& s, size_t n)
+{
+  s.x.resize(n); s.y.resize(n); s.vx.resize(n); s.vy.resize(n);
+  s.rot.resize(n); s.anim.resize(n); s.frame.resize(n);
+  s.xform.resize(n * 6); s.visible.resize(n); s.instances.resize(n * 8);
+
+  srand(1);
+  for(size_t i = 0; i < n; ++i)
+  {
+    s.x[i]  = rand() / (float)RAND_MAX * 200 - 100;
+    s.y[i]  = rand() / (float)RAND_MAX * 200 - 100;
+    s.vx[i] = rand() / (float)RAND_MAX * 2 - 1;
+    s.vy[i] = rand() / (float)RAND_MAX * 2 - 1;
+    s.rot[i]   = 0;
+    s.anim[i]  = rand() / (float)RAND_MAX * 0.6f;
+    s.frame[i] = 0;
+  }
+}
+
+static void update(scene& s, float dt, size_t grain)
+{
+  size_t n = s.x.size();
+
+  //animation state + movement
+  jobs.parallel_for(n, grain, [&](size_t begin, size_t end) {
+    for(size_t i = begin; i < end; ++i)
+    {
+      s.anim[i] += dt;
+      if(s.anim[i] >= 0.6f) { s.anim[i] = 0; s.frame[i] ^= 1; }
+      s.x[i] += s.vx[i] * dt;
+      s.y[i] += s.vy[i] * dt;
+      s.rot[i] += dt;
+    }
+  });
+
+  //transforms and culling against a view rect
+  jobs.parallel_for(n, grain, [&](size_t begin, size_t end) {
+    for(size_t i = begin; i < end; ++i)
+    {
+      float c = std::cos(s.rot[i]), sn = std::sin(s.rot[i]);
+      float* m = &s.xform[i * 6];
+      m[0] = c; m[1] = -sn; m[2] = s.x[i];
+      m[3] = sn; m[4] = c;  m[5] = s.y[i];
+      s.visible[i] = std::fabs(s.x[i]) < 60 && std::fabs(s.y[i]) < 60;
+    }
+  });
+
+  //instance fill: count per chunk, prefix sum, then compact in parallel
+  size_t chunk  = grain;
+  size_t chunks = (n + chunk - 1) / chunk;
+  s.chunk_counts.assign(chunks + 1, 0);
+
+  jobs.parallel_for(chunks, 1, [&](size_t begin, size_t end) {
+    for(size_t c = begin; c < end; ++c)
+    {
+      size_t count = 0, last = (c + 1) * chunk < n ? (c + 1) * chunk : n;
+      for(size_t i = c * chunk; i < last; ++i)
+        count += s.visible[i];
+      s.chunk_counts[c + 1] = count;
+    }
+  });
+
+  for(size_t c = 0; c < chunks; ++c)
+    s.chunk_counts[c + 1] += s.chunk_counts[c];
+
+  jobs.parallel_for(chunks, 1, [&](size_t begin, size_t end) {
+    for(size_t c = begin; c < end; ++c)
+    {
+      float* out = &s.instances[s.chunk_counts[c] * 8];
+      size_t last = (c + 1) * chunk < n ? (c + 1) * chunk : n;
+      for(size_t i = c * chunk; i < last; ++i)
+      {
+        if(!s.visible[i])
+          continue;
+
+        const float* m = &s.xform[i * 6];
+        out[0] = m[0]; out[1] = m[1]; out[2] = m[2];
+        out[3] = m[3]; out[4] = m[4]; out[5] = m[5];
+        out[6] = (float)s.frame[i];
+        out[7] = 0;
+        out += 8;
+      }
+    }
+  });
+}
+
+//with 0 workers a job that nobody waits on still has to run
+static bool check_zero_workers()
+{
+  jobs.init(0);
+
+  int ran = 0;
+  jobs.run([](void* data, size_t, size_t) { ++*(int*)data; }, &ran, 0, 1, nullptr);
+
+  job_counter counter;
+  jobs.run([](void* data, size_t, size_t) { ++*(int*)data; }, &ran, 0, 1, &counter);
+  bool done = counter.done();
+
+  jobs.shutdown();
+
+  if(ran != 2 || !done)
+  {
+    fprintf(stderr, "ERROR: run() with 0 workers did not execute inline (%d of 2 ran)\n", ran);
+    return false;
+  }
+
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  if(!check_zero_workers())
+    return 1;
+
+  size_t n    = argc > 1 ? strtoul(argv[1], nullptr, 10) : 500000;
+  int    maxt = argc > 2 ? atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+  maxt = maxt < 1 ? 1 : maxt;
+
+  scene s;
+  make_scene(s, n);
+
+  printf("%zu sprites, %d hardware threads\n", n, (int)std::thread::hardware_concurrency());
+  printf("threads    ms/frame    speedup\n");
+
+  double base = 0;
+  for(int t = 1; t <= maxt; ++t)
+  {
+    jobs.init(t - 1);
+
+    const int warmup = 5, frames = 50;
+    for(int f = 0; f < warmup; ++f)
+      update(s, 1 / 60.f, 4096);
+
+    auto start = std::chrono::steady_clock::now();
+    for(int f = 0; f < frames; ++f)
+      update(s, 1 / 60.f, 4096);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+
+    if(t == 1)
+      base = ms;
+
+    printf("%7d %11.3f %10.2fx\n", t, ms, base / ms);
+    jobs.shutdown();
+  }
+
+  return 0;
+}
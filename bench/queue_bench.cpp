@@ -0,0 +1,77 @@
+// sorting render queue keys: parallel radix sort against std::stable_sort.
+//
+//   g++ -std=c++17 -O2 -march=native -pthread -I. bench/queue_bench.cpp radix_sort.cpp render_queue.cpp stream_buffer.cpp jobs.cpp gl.c -o queue_bench
+//   ./queue_bench [max threads]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "jobs.hpp"
+#include "radix_sort.hpp"
+#include "render_queue.hpp"
+
+static std::vector<sort_item> make_keys(size_t n)
+{
+  std::mt19937 rng(7);
+  std::vector<sort_item> items(n);
+
+  //a realistic mix: few layers, programs and textures, mostly translucent
+  for(size_t i = 0; i < n; ++i)
+  {
+    uint8_t layer = rng() % 8;
+    bool    trans = rng() % 4 != 0;
+    items[i] = {make_sort_key(layer, trans, 1 + rng() % 16, 1 + rng() % 64, (rng() % 10000) / 10000.f), (uint32_t)i, 0};
+  }
+
+  return items;
+}
+
+template <typename F>
+static double time_ms(int reps, const F& f)
+{
+  double total = 0;
+  for(int i = 0; i < reps; ++i)
+  {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    total += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+  return total / reps;
+}
+
+int main(int argc, char* argv[])
+{
+  int maxt = argc > 1 ? atoi(argv[1]) : (int)std::thread::hardware_concurrency();
+  maxt = maxt < 1 ? 1 : maxt;
+
+  printf("%-9s %8s %12s %10s\n", "commands", "threads", "radix ms", "stable ms");
+
+  for(size_t n : {10000, 100000, 1000000})
+  {
+    std::vector<sort_item> keys = make_keys(n), work(n), scratch(n);
+
+    double std_ms = time_ms(5, [&] {
+      work = keys;
+      std::stable_sort(work.begin(), work.end(), [](const sort_item& a, const sort_item& b) { return a.key < b.key; });
+    });
+
+    for(int t = 1; t <= maxt; ++t)
+    {
+      jobs.init(t - 1);
+      double radix_ms = time_ms(5, [&] {
+        work = keys;
+        radix_sort(work.data(), scratch.data(), n);
+      });
+      jobs.shutdown();
+
+      printf("%-9zu %8d %12.3f %10.3f\n", n, t, radix_ms, std_ms);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,313 @@
+// headless gpu benchmark for the sprite paths. draws n sprites into an
+// offscreen target from a hidden window and reports upload and gpu time.
+//
+//   g++ -std=c++17 -O2 -march=native -pthread -I. bench/render_bench.cpp sprites.cpp jobs.cpp quad_batch.cpp stream_buffer.cpp gl.c -lglfw -o render_bench
+//   ./render_bench [sprites]
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+#include <glad/gl.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "jobs.hpp"
+#include "quad_batch.hpp"
+#include "quantize.hpp"
+#include "sprites.hpp"
+#include "vertex_layout.hpp"
+
+static const int target_size = 512;
+static const int frames      = 60;
+
+// the pre-quantisation layouts, kept here as the reference
+struct float_vertex
+{
+  attrib<float, 3> pos;
+  attrib<float, 4> col;
+  attrib<float, 2> uv;
+};
+
+struct float_instance
+{
+  attrib<float, 2> pos;
+  attrib<float, 2> scale;
+  attrib<float, 1> u_offset;
+  float            texture, layer, pad; //not read by the shader
+};
+
+VERTEX_LAYOUT(float_vertex, pos, col, uv);
+VERTEX_LAYOUT(float_instance, pos, scale, u_offset);
+
+// same as vertex in renderer.hpp
+struct compact_vertex
+{
+  attrib<int16_t, 3, attrib_kind::NORMALIZED>  pos;
+  int16_t                                      pad;
+  attrib<uint8_t, 4, attrib_kind::NORMALIZED>  col;
+  attrib<uint16_t, 2, attrib_kind::NORMALIZED> uv;
+};
+
+VERTEX_LAYOUT(compact_vertex, pos, col, uv);
+
+static const char* vs_src =
+  "#version 450\n"
+  "layout(location = 0) in vec3 a_pos;\n"
+  "layout(location = 1) in vec4 a_col;\n"
+  "layout(location = 2) in vec2 a_uv;\n"
+  "layout(location = 3) in vec2 a_offset;\n"
+  "layout(location = 4) in vec2 a_scale;\n"
+  "layout(location = 5) in float a_u_offset;\n"
+  "out vec4 v_col;\n"
+  "void main() {\n"
+  "  gl_Position = vec4(a_pos.xy * a_scale + a_offset, 0.0, 1.0);\n"
+  "  v_col = a_col * vec4(a_uv + vec2(a_u_offset, 0.0), 1.0, 1.0);\n"
+  "}\n";
+
+static const char* batch_vs_src =
+  "#version 450\n"
+  "layout(location = 0) in vec3 a_pos;\n"
+  "layout(location = 1) in vec4 a_col;\n"
+  "layout(location = 2) in vec2 a_uv;\n"
+  "out vec4 v_col;\n"
+  "void main() {\n"
+  "  gl_Position = vec4(a_pos.xy, 0.0, 1.0);\n"
+  "  v_col = a_col * vec4(a_uv, 1.0, 1.0);\n"
+  "}\n";
+
+static const char* fs_src =
+  "#version 450\n"
+  "in vec4 v_col;\n"
+  "out vec4 fragColor;\n"
+  "void main() { fragColor = v_col; }\n";
+
+static unsigned int compile(const char* vs_text, const char* fs_text)
+{
+  unsigned int vs = glCreateShader(GL_VERTEX_SHADER);
+  glShaderSource(vs, 1, &vs_text, NULL);
+  glCompileShader(vs);
+
+  unsigned int fs = glCreateShader(GL_FRAGMENT_SHADER);
+  glShaderSource(fs, 1, &fs_text, NULL);
+  glCompileShader(fs);
+
+  unsigned int prg = glCreateProgram();
+  glAttachShader(prg, vs);
+  glAttachShader(prg, fs);
+  glLinkProgram(prg);
+  glDeleteShader(vs);
+  glDeleteShader(fs);
+
+  int status = 0;
+  glGetProgramiv(prg, GL_LINK_STATUS, &status);
+  if(!status)
+    fprintf(stderr, "ERROR: benchmark program failed to link\n");
+
+  return prg;
+}
+
+struct result
+{
+  double frame_ms = 0; //wall clock for fill + draw + finish
+  double gpu_ms   = 0; //gpu time over the same commands
+  size_t bytes    = 0;
+  int    count    = 0;
+};
+
+// one frame is fill() (cpu work and uploads) followed by draw(). the
+// batcher issues draws from inside fill() whenever a chunk is full, so the
+// whole frame is measured rather than splitting cpu and gpu parts.
+template <typename FILL, typename DRAW>
+static result run(size_t bytes, int count, const FILL& fill, const DRAW& draw)
+{
+  unsigned int query;
+  glCreateQueries(GL_TIME_ELAPSED, 1, &query);
+
+  result r;
+  r.bytes = bytes;
+  r.count = count;
+
+  for(int f = 0; f < frames; ++f)
+  {
+    glClear(GL_COLOR_BUFFER_BIT);
+    glFinish();
+
+    auto start = std::chrono::steady_clock::now();
+    glBeginQuery(GL_TIME_ELAPSED, query);
+    fill();
+    draw();
+    glEndQuery(GL_TIME_ELAPSED);
+    glFinish();
+    r.frame_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    GLuint64 ns = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+    r.gpu_ms += ns / 1e6;
+  }
+
+  glDeleteQueries(1, &query);
+  r.frame_ms /= frames;
+  r.gpu_ms   /= frames;
+  return r;
+}
+
+static void report(const char* name, const result& r)
+{
+  printf("%-10s %10.2f MB %10.3f ms %10.3f ms %10.1f M/s\n",
+         name, r.bytes / 1e6, r.frame_ms, r.gpu_ms, r.count / r.frame_ms / 1e3);
+}
+
+int main(int argc, char* argv[])
+{
+  int n = argc > 1 ? atoi(argv[1]) : 200000;
+
+  if(!glfwInit())
+    return 1;
+
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+  GLFWwindow* window = glfwCreateWindow(64, 64, "render-bench", NULL, NULL);
+  if(!window)
+  {
+    fprintf(stderr, "ERROR: failed to create hidden window\n");
+    glfwTerminate();
+    return 1;
+  }
+
+  glfwMakeContextCurrent(window);
+  gladLoadGL(glfwGetProcAddress);
+  jobs.init();
+
+  unsigned int color, fbo;
+  glCreateRenderbuffers(1, &color);
+  glNamedRenderbufferStorage(color, GL_RGBA8, target_size, target_size);
+  glCreateFramebuffers(1, &fbo);
+  glNamedFramebufferRenderbuffer(fbo, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glViewport(0, 0, target_size, target_size);
+
+  unsigned int prg       = compile(vs_src, fs_src);
+  unsigned int batch_prg = compile(batch_vs_src, fs_src);
+
+  //tiny sprites spread over the target so vertex work dominates
+  sprite_store sprites;
+  sprites.reserve(n);
+  for(int i = 0; i < n; ++i)
+  {
+    sprite_desc d;
+    d.x  = rand() / (float)RAND_MAX * 2 - 1;
+    d.y  = rand() / (float)RAND_MAX * 2 - 1;
+    d.sx = d.sy = 0.004f;
+    d.frame = i & 1;
+    sprites.create(d);
+  }
+
+  float_vertex fquad[4] = {
+    {{-0.5, 0.5, 0}, {1, 0, 0, 1}, {0.0, 0}}, {{0.5, 0.5, 0}, {1, 0, 0, 1}, {0.5, 0}},
+    {{-0.5,-0.5, 0}, {0, 1, 0, 1}, {0.0, 1}}, {{0.5,-0.5, 0}, {0, 0, 1, 1}, {0.5, 1}},
+  };
+  compact_vertex cquad[4];
+  for(int i = 0; i < 4; ++i)
+  {
+    const float_vertex& f = fquad[i];
+    cquad[i] = { {snorm16(f.pos[0]), snorm16(f.pos[1]), snorm16(f.pos[2])}, 0,
+                 {unorm8(f.col[0]), unorm8(f.col[1]), unorm8(f.col[2]), unorm8(f.col[3])},
+                 {unorm16(f.uv[0]), unorm16(f.uv[1])} };
+  }
+
+  std::vector<float_instance>  finst(n);
+  std::vector<sprite_instance> cinst(n);
+
+  unsigned int buffers[4];
+  glCreateBuffers(4, buffers);
+  glNamedBufferStorage(buffers[0], sizeof(fquad), fquad, 0);
+  glNamedBufferStorage(buffers[1], sizeof(cquad), cquad, 0);
+  glNamedBufferStorage(buffers[2], n * sizeof(float_instance), nullptr, GL_DYNAMIC_STORAGE_BIT);
+  glNamedBufferStorage(buffers[3], n * sizeof(sprite_instance), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+  unsigned int vaos[2];
+  glCreateVertexArrays(2, vaos);
+
+  bind_vertex_buffer<float_vertex>(vaos[0], 0, buffers[0], 0);
+  bind_vertex_buffer<float_instance>(vaos[0], 1, buffers[2], 0);
+  setup_vertex_layout<float_vertex>(vaos[0], 0, 0);
+  setup_vertex_layout<float_instance>(vaos[0], 1, 3, 1);
+
+  //compact layout, same as renderer.cpp
+  bind_vertex_buffer<compact_vertex>(vaos[1], 0, buffers[1], 0);
+  bind_vertex_buffer<sprite_instance>(vaos[1], 1, buffers[3], 0);
+  setup_vertex_layout<compact_vertex>(vaos[1], 0, 0);
+  setup_vertex_layout<sprite_instance>(vaos[1], 1, 3, 1);
+
+  printf("%d sprites, %dx%d target, %d frames, %s\n", n, target_size, target_size, frames, glGetString(GL_RENDERER));
+  printf("%-10s %13s %13s %13s %12s\n", "path", "upload/frame", "frame", "gpu", "sprites");
+
+  auto draw_instanced = [&](unsigned int vao) {
+    return [=] {
+      glBindVertexArray(vao);
+      glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, n);
+    };
+  };
+
+  glUseProgram(prg);
+  result f = run(n * sizeof(float_instance), n, [&] {
+    const sprite_store& s = sprites;
+    for(int i = 0; i < n; ++i)
+      finst[i] = { {s.pos_x[i], s.pos_y[i]}, {s.scale_x[i], s.scale_y[i]}, {s.frame[i] * (1.f / sprite_frames)}, 0, 0, 0 };
+    glNamedBufferSubData(buffers[2], 0, n * sizeof(float_instance), finst.data());
+  }, draw_instanced(vaos[0]));
+  report("float", f);
+
+  result c = run(n * sizeof(sprite_instance), n, [&] {
+    sprites_pack_instances(sprites, cinst.data());
+    glNamedBufferSubData(buffers[3], 0, n * sizeof(sprite_instance), cinst.data());
+  }, draw_instanced(vaos[1]));
+  report("compact", c);
+
+  //non-instanced: corners are expanded on the cpu and written straight
+  //into the batcher's mapped stream, one draw per 16k quads
+  quad_batcher batcher;
+  batcher.create(n);
+
+  result b = run(n * 4 * sizeof(batch_vertex), n, [&] {
+    batcher.begin_frame();
+    batcher.set_state(batch_prg, 0, 0);
+
+    const sprite_store& s = sprites;
+    for(int i = 0; i < n; ++i)
+    {
+      batch_vertex* v = batcher.add_quad();
+      float hx = s.scale_x[i] * 0.5f, hy = s.scale_y[i] * 0.5f;
+      uint16_t u0 = unorm16(s.frame[i] * (1.f / sprite_frames));
+      uint16_t u1 = unorm16((s.frame[i] + 1) * (1.f / sprite_frames));
+      for(int k = 0; k < 4; ++k)
+      {
+        const float_vertex& q = fquad[k];
+        v[k].pos = {{ s.pos_x[i] + (q.pos[0] < 0 ? -hx : hx), s.pos_y[i] + (q.pos[1] < 0 ? -hy : hy), 0 }};
+        v[k].col = {{ unorm8(q.col[0]), unorm8(q.col[1]), unorm8(q.col[2]), unorm8(q.col[3]) }};
+        v[k].uv  = {{ q.uv[0] > 0 ? u1 : u0, unorm16(q.uv[1]) }};
+      }
+    }
+  }, [&] {
+    batcher.end_frame();
+  });
+  report("batched", b);
+
+  printf("compact vs float: %.2fx less upload, %.2fx frame, %.2fx gpu\n",
+         (double)f.bytes / c.bytes, f.frame_ms / c.frame_ms, f.gpu_ms / c.gpu_ms);
+  printf("instanced vs batched: %.2fx less upload, %.2fx frame, %.2fx gpu, %d draws per batched frame\n",
+         (double)b.bytes / c.bytes, b.frame_ms / c.frame_ms, b.gpu_ms / c.gpu_ms, batcher.draw_calls);
+
+  batcher.destroy();
+
+  jobs.shutdown();
+  glfwTerminate();
+  return 0;
+}
@@ -0,0 +1,146 @@
+// sweep and prune over moving agents: first tick (full sort) against the
+// frame coherent ticks after it. checked against brute force on a small set.
+//
+//   g++ -std=c++17 -O2 -march=native -pthread -I. bench/sap_bench.cpp sweep_prune.cpp radix_sort.cpp jobs.cpp -o sap_bench
+//   ./sap_bench [agents] [ticks]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "jobs.hpp"
+#include "sweep_prune.hpp"
+
+struct agents
+{
+  std::vector<float> x, y, vx, vy, ex, ey;
+  std::vector<float> min_x, min_y, max_x, max_y;
+
+  void spawn(size_t n, float world, std::mt19937& rng)
+  {
+    std::uniform_real_distribution<float> pos(-world, world), vel(-1.f, 1.f), size(0.02f, 0.06f);
+    x.resize(n); y.resize(n); vx.resize(n); vy.resize(n); ex.resize(n); ey.resize(n);
+    min_x.resize(n); min_y.resize(n); max_x.resize(n); max_y.resize(n);
+
+    for(size_t i = 0; i < n; ++i)
+    {
+      x[i]  = pos(rng); y[i]  = pos(rng);
+      vx[i] = vel(rng); vy[i] = vel(rng);
+      ex[i] = size(rng); ey[i] = size(rng);
+    }
+  }
+
+  void step(float dt, float world)
+  {
+    for(size_t i = 0; i < x.size(); ++i)
+    {
+      x[i] += vx[i] * dt;
+      y[i] += vy[i] * dt;
+      if(x[i] < -world || x[i] > world) vx[i] = -vx[i];
+      if(y[i] < -world || y[i] > world) vy[i] = -vy[i];
+
+      min_x[i] = x[i] - ex[i]; max_x[i] = x[i] + ex[i];
+      min_y[i] = y[i] - ey[i]; max_y[i] = y[i] + ey[i];
+    }
+  }
+
+  box_soa boxes() const
+  {
+    box_soa b;
+    b.min_x = min_x.data(); b.min_y = min_y.data();
+    b.max_x = max_x.data(); b.max_y = max_y.data();
+    b.count = x.size();
+    return b;
+  }
+};
+
+static bool pair_less(const collision_pair& p, const collision_pair& q)
+{
+  return p.a != q.a ? p.a < q.a : p.b < q.b;
+}
+
+static bool check(size_t n)
+{
+  std::mt19937 rng(5);
+  agents a;
+  a.spawn(n, 2.f, rng);
+
+  sweep_and_prune sap;
+  std::vector<collision_pair> pairs, brute;
+
+  for(int tick = 0; tick < 10; ++tick)
+  {
+    a.step(1.f / 60.f, 2.f);
+    sap.update(a.boxes(), pairs);
+
+    brute.clear();
+    for(uint32_t i = 0; i < n; ++i)
+      for(uint32_t j = i + 1; j < n; ++j)
+        if(a.min_x[i] <= a.max_x[j] && a.min_x[j] <= a.max_x[i] && a.min_y[i] <= a.max_y[j] && a.min_y[j] <= a.max_y[i])
+          brute.push_back({i, j});
+
+    std::sort(pairs.begin(), pairs.end(), pair_less);
+    if(pairs.size() != brute.size() || !std::equal(pairs.begin(), pairs.end(), brute.begin(),
+                                                   [](const collision_pair& p, const collision_pair& q) { return p.a == q.a && p.b == q.b; }))
+    {
+      fprintf(stderr, "ERROR: tick %d: %zu pairs, brute force found %zu\n", tick, pairs.size(), brute.size());
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  size_t count = argc > 1 ? strtoul(argv[1], nullptr, 10) : 100000;
+  int    ticks = argc > 2 ? atoi(argv[2]) : 120;
+
+  jobs.init();
+
+  if(!check(3000))
+    return 1;
+
+  //about as dense as a busy flock, a few overlaps per agent
+  const float world = 20.f;
+  std::mt19937 rng(9);
+  agents a;
+  a.spawn(count, world, rng);
+
+  sweep_and_prune sap;
+  std::vector<collision_pair> pairs;
+
+  double first_ms = 0, sum_ms = 0, max_ms = 0;
+  size_t swaps = 0, rebuilds = 0;
+
+  for(int tick = 0; tick < ticks; ++tick)
+  {
+    a.step(1.f / 60.f, world);
+
+    auto start = std::chrono::steady_clock::now();
+    sap.update(a.boxes(), pairs);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    if(tick == 0)
+    {
+      first_ms = ms;
+      continue;
+    }
+
+    sum_ms += ms;
+    max_ms  = ms > max_ms ? ms : max_ms;
+    swaps  += sap.moves;
+    rebuilds += sap.rebuilt;
+  }
+
+  printf("%zu agents, %zu pairs on the last tick\n", count, pairs.size());
+  printf("first tick (full sort)   %8.3f ms\n", first_ms);
+  printf("coherent ticks avg/max   %8.3f / %.3f ms\n", sum_ms / (ticks - 1), max_ms);
+  printf("moves per tick           %8.0f, %zu rebuilds\n", swaps / (double)(ticks - 1), rebuilds);
+
+  jobs.shutdown();
+  return 0;
+}
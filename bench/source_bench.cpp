@@ -0,0 +1,99 @@
+// shader source loading: the old getline loader against one sized read,
+// and a cold versus cached #include expansion of a generated library.
+//
+//   g++ -std=c++17 -O2 -march=native -pthread -I. bench/source_bench.cpp source_files.cpp program_cache.cpp gl.c -o source_bench
+//   ./source_bench [files] [lines per file]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+#include "source_files.hpp"
+
+static double now_us()
+{
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//what loadfile used to do
+static bool getline_load(const std::string& path, std::string& src)
+{
+  std::ifstream file(path, std::fstream::binary);
+  std::string line;
+  src = "";
+
+  if(!file.is_open())
+    return false;
+
+  while(std::getline(file, line))
+    src += line;
+
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  int files = argc > 1 ? atoi(argv[1]) : 64;
+  int lines = argc > 2 ? atoi(argv[2]) : 400;
+
+  char dir[] = "/tmp/source_bench_XXXXXX";
+  if(!mkdtemp(dir))
+    return 1;
+
+  //a root including every library file, each of which includes common.glsl
+  std::string root = std::string(dir) + "/root.frag";
+  {
+    std::ofstream common(std::string(dir) + "/common.glsl");
+    common << "const float PI = 3.14159265;\n";
+
+    std::ofstream r(root);
+    r << "#version 450\n";
+
+    for(int f = 0; f < files; ++f)
+    {
+      std::string name = "lib" + std::to_string(f) + ".glsl";
+      std::ofstream lib(std::string(dir) + "/" + name);
+      lib << "#include \"common.glsl\"\n";
+      for(int l = 0; l < lines; ++l)
+        lib << "float f" << f << "_" << l << "(float x) { return sin(x * PI + " << l << ".0); } //filler\n";
+
+      r << "#include \"" << name << "\"\n";
+    }
+
+    r << "void main() {}\n";
+  }
+
+  size_t bytes = 0;
+  std::string text;
+
+  double t0 = now_us();
+  for(int f = 0; f < files; ++f)
+  {
+    getline_load(std::string(dir) + "/lib" + std::to_string(f) + ".glsl", text);
+    bytes += text.size();
+  }
+  double t1 = now_us();
+  for(int f = 0; f < files; ++f)
+    read_file(std::string(dir) + "/lib" + std::to_string(f) + ".glsl", text);
+  double t2 = now_us();
+
+  const shader_source* src = shader_library.load(root);
+  double t3 = now_us();
+
+  const int repeats = 100;
+  for(int i = 0; i < repeats; ++i)
+    src = shader_library.load(root);
+  double t4 = now_us();
+
+  printf("%d files, %.1f KB\n", files + 2, bytes / 1024.0);
+  printf("  getline, all files   %8.1f us\n", t1 - t0);
+  printf("  read_file, all files %8.1f us\n", t2 - t1);
+  printf("  expand cold          %8.1f us  (%zu files, %zu bytes)\n", t3 - t2, src ? src->files.size() : 0, src ? src->text.size() : 0);
+  printf("  expand cached        %8.1f us\n", (t4 - t3) / repeats);
+
+  std::string cmd = std::string("rm -r ") + dir;
+  return system(cmd.c_str()) != 0;
+}
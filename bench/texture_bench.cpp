@@ -0,0 +1,105 @@
+// texture load time: png decode through the Image library against mapping
+// the cooked container, both ending with every byte copied out the way
+// the upload copies into the staging ring.
+//
+//   g++ -std=c++17 -O2 -march=native -pthread -I. bench/texture_bench.cpp texture_file.cpp texture_compress.cpp mipmap.cpp jobs.cpp -limage -o texture_bench
+//   ./texture_bench [textures] [size]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "texture_file.hpp"
+
+extern "C" {
+  #include <image.h>
+}
+
+static double now_ms()
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//smooth gradients with some noise, compresses about like real art
+static void fill(Image& img, int seed)
+{
+  unsigned rng = seed * 2654435761u + 1;
+  for(int y = 0; y < img.h; ++y)
+    for(int x = 0; x < img.w; ++x)
+    {
+      rng = rng * 1664525u + 1013904223u;
+      unsigned char* p = img.data + ((size_t)y * img.w + x) * 4;
+      p[0] = (unsigned char)(x * 255 / img.w + (rng >> 29));
+      p[1] = (unsigned char)(y * 255 / img.h);
+      p[2] = (unsigned char)((x ^ y) + seed);
+      p[3] = 255;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+  int count = argc > 1 ? atoi(argv[1]) : 16;
+  int size  = argc > 2 ? atoi(argv[2]) : 1024;
+
+  char dir[] = "/tmp/texture_bench_XXXXXX";
+  if(!mkdtemp(dir))
+    return 1;
+
+  std::vector<std::string> paths;
+  for(int i = 0; i < count; ++i)
+  {
+    Image img = {};
+    Image_alloc(&img, size, size, 4);
+    fill(img, i);
+
+    paths.push_back(std::string(dir) + "/tex" + std::to_string(i) + ".png");
+    Image_save(img, paths.back().c_str());
+    cook_texture(paths.back() + ".gtex", img.data, size, size, true);
+    Image_free(&img);
+  }
+
+  std::vector<unsigned char> staging((size_t)size * size * 4 * 2);
+  size_t png_bytes = 0, cooked_bytes = 0;
+
+  //both runs read warm files, the difference is decoding
+  double t0 = now_ms();
+  for(const std::string& p : paths)
+  {
+    Image img = {};
+    Image_load(&img, p.c_str());
+    memcpy(staging.data(), img.data, (size_t)img.w * img.h * 4);
+    png_bytes += (size_t)img.w * img.h * 4;
+    Image_free(&img);
+  }
+  double t1 = now_ms();
+
+  for(const std::string& p : paths)
+  {
+    texture_file f;
+    if(!f.open(p + ".gtex"))
+      return 1;
+
+    size_t at = 0;
+    for(uint32_t l = 0; l < f.header->levels; ++l)
+    {
+      memcpy(staging.data() + at, f.level_data(l), f.levels[l].size);
+      at += f.levels[l].size;
+    }
+
+    cooked_bytes += at;
+    f.close();
+  }
+  double t2 = now_ms();
+
+  printf("%d textures of %dx%d\n", count, size, size);
+  printf("  png decode       %8.2f ms  (%.1f MB, level 0 only)\n", t1 - t0, png_bytes / 1048576.0);
+  printf("  cooked mmap      %8.2f ms  (%.1f MB, full mip chain)\n", t2 - t1, cooked_bytes / 1048576.0);
+  printf("  speedup          %8.1fx\n", (t1 - t0) / (t2 - t1));
+
+  std::string cmd = std::string("rm -r ") + dir;
+  return system(cmd.c_str()) != 0;
+}
@@ -0,0 +1,266 @@
+#include "bird_env.hpp"
+
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "jobs.hpp"
+
+static const size_t env_grain = 1024;
+
+static inline uint32_t xorshift(uint32_t& x)
+{
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return x;
+}
+
+// uniform in [-range, range] from the top 24 bits
+static inline float random_gap(uint32_t& x, float range)
+{
+  return ((xorshift(x) >> 8) * (2.f / 16777216.f) - 1.f) * range;
+}
+
+// spelled out so the scalar and avx2 kernels round the same way whether
+// or not the compiler contracts a * b + c on its own
+static inline float madd(float a, float b, float c)
+{
+#if defined(__FMA__)
+  return std::fma(a, b, c);
+#else
+  return a * b + c;
+#endif
+}
+
+void bird_env_batch::create(size_t count, uint32_t seed, const bird_env_config& cfg)
+{
+  config = cfg;
+
+  y.assign(count, 0.f);
+  vy.assign(count, 0.f);
+  pipe_x.assign(count, cfg.pipe_start);
+  gap_y.assign(count, 0.f);
+  steps.assign(count, 0);
+  rng.resize(count);
+  score.assign(count, 0.f);
+
+  //xorshift must not start at 0
+  uint32_t s = seed ? seed : 0x9e3779b9u;
+  for(size_t i = 0; i < count; ++i)
+    rng[i] = xorshift(s) | 1;
+}
+
+static inline void write_obs(const bird_env_batch& e, size_t i, float* obs)
+{
+  float* o = obs + i * bird_env_batch::obs_size;
+  o[0] = e.y[i];
+  o[1] = e.vy[i];
+  o[2] = e.pipe_x[i];
+  o[3] = e.gap_y[i] - e.y[i];
+}
+
+void bird_env_batch::reset(float* obs)
+{
+  jobs.parallel_for(size(), env_grain, [&](size_t begin, size_t end) {
+    for(size_t i = begin; i < end; ++i)
+    {
+      y[i]      = 0;
+      vy[i]     = 0;
+      pipe_x[i] = config.pipe_start;
+      gap_y[i]  = random_gap(rng[i], config.gap_range);
+      steps[i]  = 0;
+      score[i]  = 0;
+
+      if(obs)
+        write_obs(*this, i, obs);
+    }
+  });
+}
+
+static void step_scalar(bird_env_batch& e, size_t begin, size_t end,
+                        const uint8_t* actions, float* obs, float* rewards, uint8_t* dones)
+{
+  const bird_env_config& c = e.config;
+  const float fall   = c.gravity * c.dt;
+  const float scroll = c.scroll * c.dt;
+
+  for(size_t i = begin; i < end; ++i)
+  {
+    float vy = actions[i] ? c.flap_speed : e.vy[i] - fall;
+    float y  = madd(vy, c.dt, e.y[i]);
+    float px = e.pipe_x[i] - scroll;
+    float gy = e.gap_y[i];
+    float reward = 0;
+
+    //the pipe left the screen behind the bird: scored, next one
+    if(px < -c.pipe_half_w - c.bird_radius)
+    {
+      px += c.pipe_gap;
+      gy  = random_gap(e.rng[i], c.gap_range);
+      reward = 1;
+    }
+
+    bool in_pipe = std::fabs(px) < c.pipe_half_w + c.bird_radius &&
+                   std::fabs(y - gy) > c.gap_half - c.bird_radius;
+    bool crashed = in_pipe || y < -1.f || y > 1.f;
+    int  steps   = e.steps[i] + 1;
+    bool done    = crashed || steps >= c.max_steps;
+
+    reward = crashed ? -1.f : reward;
+
+    if(done)
+    {
+      y = vy = 0;
+      px = c.pipe_start;
+      gy = random_gap(e.rng[i], c.gap_range);
+      steps = 0;
+    }
+
+    e.y[i]      = y;
+    e.vy[i]     = vy;
+    e.pipe_x[i] = px;
+    e.gap_y[i]  = gy;
+    e.steps[i]  = steps;
+    e.score[i]  = done ? 0 : e.score[i] + (reward > 0);
+
+    rewards[i] = reward;
+    dones[i]   = done;
+    write_obs(e, i, obs);
+  }
+}
+
+#if defined(__AVX2__)
+static inline __m256i xorshift8(__m256i x)
+{
+  x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 13));
+  x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 17));
+  x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 5));
+  return x;
+}
+
+static inline __m256 random_gap8(__m256i x, __m256 range)
+{
+  __m256 u = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(x, 8)), _mm256_set1_ps(2.f / 16777216.f));
+  return _mm256_mul_ps(_mm256_sub_ps(u, _mm256_set1_ps(1.f)), range);
+}
+
+// the same game as step_scalar, 8 lanes at a time. branches become blends,
+// a lane only advances its rng when it actually draws a gap.
+static size_t step_avx2(bird_env_batch& e, size_t begin, size_t end,
+                        const uint8_t* actions, float* obs, float* rewards, uint8_t* dones)
+{
+  const bird_env_config& c = e.config;
+
+  const __m256 dt         = _mm256_set1_ps(c.dt);
+  const __m256 fall       = _mm256_set1_ps(c.gravity * c.dt);
+  const __m256 flap       = _mm256_set1_ps(c.flap_speed);
+  const __m256 scroll     = _mm256_set1_ps(c.scroll * c.dt);
+  const __m256 pass_x     = _mm256_set1_ps(-c.pipe_half_w - c.bird_radius);
+  const __m256 pipe_gap   = _mm256_set1_ps(c.pipe_gap);
+  const __m256 hit_x      = _mm256_set1_ps(c.pipe_half_w + c.bird_radius);
+  const __m256 hit_y      = _mm256_set1_ps(c.gap_half - c.bird_radius);
+  const __m256 range      = _mm256_set1_ps(c.gap_range);
+  const __m256 start      = _mm256_set1_ps(c.pipe_start);
+  const __m256 one        = _mm256_set1_ps(1.f);
+  const __m256 zero       = _mm256_setzero_ps();
+  const __m256 abs_mask   = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+  const __m256i max_steps = _mm256_set1_epi32(c.max_steps);
+
+  size_t i = begin;
+  for(; i + 8 <= end; i += 8)
+  {
+    __m256i act = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(actions + i)));
+    __m256  flapped = _mm256_castsi256_ps(_mm256_cmpgt_epi32(act, _mm256_setzero_si256()));
+
+    __m256 vy = _mm256_blendv_ps(_mm256_sub_ps(_mm256_loadu_ps(&e.vy[i]), fall), flap, flapped);
+#if defined(__FMA__)
+    __m256 y  = _mm256_fmadd_ps(vy, dt, _mm256_loadu_ps(&e.y[i]));
+#else
+    __m256 y  = _mm256_add_ps(_mm256_loadu_ps(&e.y[i]), _mm256_mul_ps(vy, dt));
+#endif
+    __m256 px = _mm256_sub_ps(_mm256_loadu_ps(&e.pipe_x[i]), scroll);
+    __m256 gy = _mm256_loadu_ps(&e.gap_y[i]);
+    __m256i rng = _mm256_loadu_si256((const __m256i*)&e.rng[i]);
+
+    __m256 passed = _mm256_cmp_ps(px, pass_x, _CMP_LT_OQ);
+    __m256i next  = xorshift8(rng);
+    rng = _mm256_blendv_epi8(rng, next, _mm256_castps_si256(passed));
+    px  = _mm256_blendv_ps(px, _mm256_add_ps(px, pipe_gap), passed);
+    gy  = _mm256_blendv_ps(gy, random_gap8(next, range), passed);
+
+    __m256 in_pipe = _mm256_and_ps(_mm256_cmp_ps(_mm256_and_ps(px, abs_mask), hit_x, _CMP_LT_OQ),
+                                   _mm256_cmp_ps(_mm256_and_ps(_mm256_sub_ps(y, gy), abs_mask), hit_y, _CMP_GT_OQ));
+    __m256 crashed = _mm256_or_ps(in_pipe, _mm256_or_ps(_mm256_cmp_ps(y, _mm256_set1_ps(-1.f), _CMP_LT_OQ),
+                                                        _mm256_cmp_ps(y, one, _CMP_GT_OQ)));
+
+    __m256i steps   = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)&e.steps[i]), _mm256_set1_epi32(1));
+    __m256  timeout = _mm256_castsi256_ps(_mm256_cmpgt_epi32(steps, _mm256_sub_epi32(max_steps, _mm256_set1_epi32(1))));
+    __m256  done    = _mm256_or_ps(crashed, timeout);
+
+    __m256 reward = _mm256_and_ps(passed, one);
+    reward = _mm256_blendv_ps(reward, _mm256_set1_ps(-1.f), crashed);
+
+    //finished lanes restart
+    next = xorshift8(rng);
+    rng   = _mm256_blendv_epi8(rng, next, _mm256_castps_si256(done));
+    y     = _mm256_blendv_ps(y, zero, done);
+    vy    = _mm256_blendv_ps(vy, zero, done);
+    px    = _mm256_blendv_ps(px, start, done);
+    gy    = _mm256_blendv_ps(gy, random_gap8(next, range), done);
+    steps = _mm256_andnot_si256(_mm256_castps_si256(done), steps);
+
+    __m256 score = _mm256_add_ps(_mm256_loadu_ps(&e.score[i]), _mm256_and_ps(_mm256_cmp_ps(reward, zero, _CMP_GT_OQ), one));
+    score = _mm256_andnot_ps(done, score);
+
+    _mm256_storeu_ps(&e.y[i], y);
+    _mm256_storeu_ps(&e.vy[i], vy);
+    _mm256_storeu_ps(&e.pipe_x[i], px);
+    _mm256_storeu_ps(&e.gap_y[i], gy);
+    _mm256_storeu_ps(&e.score[i], score);
+    _mm256_storeu_si256((__m256i*)&e.steps[i], steps);
+    _mm256_storeu_si256((__m256i*)&e.rng[i], rng);
+    _mm256_storeu_ps(rewards + i, reward);
+
+    //done lanes to bytes
+    unsigned int mask = (unsigned int)_mm256_movemask_ps(done);
+    for(int k = 0; k < 8; ++k)
+      dones[i + k] = (mask >> k) & 1;
+
+    //soa lanes to row major observations: 4x8 -> 8x4
+    __m256 rel = _mm256_sub_ps(gy, y);
+    __m256 t0 = _mm256_unpacklo_ps(y, vy);
+    __m256 t1 = _mm256_unpackhi_ps(y, vy);
+    __m256 t2 = _mm256_unpacklo_ps(px, rel);
+    __m256 t3 = _mm256_unpackhi_ps(px, rel);
+    __m256 r0 = _mm256_shuffle_ps(t0, t2, 0x44); //games 0, 4
+    __m256 r1 = _mm256_shuffle_ps(t0, t2, 0xee); //games 1, 5
+    __m256 r2 = _mm256_shuffle_ps(t1, t3, 0x44); //games 2, 6
+    __m256 r3 = _mm256_shuffle_ps(t1, t3, 0xee); //games 3, 7
+
+    float* o = obs + i * bird_env_batch::obs_size;
+    _mm256_storeu_ps(o + 0,  _mm256_permute2f128_ps(r0, r1, 0x20));
+    _mm256_storeu_ps(o + 8,  _mm256_permute2f128_ps(r2, r3, 0x20));
+    _mm256_storeu_ps(o + 16, _mm256_permute2f128_ps(r0, r1, 0x31));
+    _mm256_storeu_ps(o + 24, _mm256_permute2f128_ps(r2, r3, 0x31));
+  }
+
+  return i;
+}
+#endif
+
+void bird_env_batch::step(const uint8_t* actions, float* obs, float* rewards, uint8_t* dones)
+{
+  jobs.parallel_for(size(), env_grain, [&](size_t begin, size_t end) {
+    size_t i = begin;
+
+#if defined(__AVX2__)
+    if(simd)
+      i = step_avx2(*this, begin, end, actions, obs, rewards, dones);
+#endif
+
+    step_scalar(*this, i, end, actions, obs, rewards, dones);
+  });
+}
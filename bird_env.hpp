@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "sprites.hpp"
+
+// tuning of the headless bird game. world units, y in [-1, 1], the bird
+// sits at x = 0 and pipes scroll towards it.
+struct bird_env_config
+{
+  float dt          = 1.f / 60.f;
+  float gravity     = 3.5f;
+  float flap_speed  = 1.2f;
+  float scroll      = 0.6f;
+  float bird_radius = 0.05f;
+  float pipe_half_w = 0.1f;
+  float gap_half    = 0.25f;
+  float gap_range   = 0.6f;  //gap centres are drawn from [-range, range]
+  float pipe_start  = 1.5f;  //x of the first pipe after a reset
+  float pipe_gap    = 1.2f;  //distance to the next pipe
+  int   max_steps   = 3600;  //episodes are cut after a minute
+};
+
+// many independent flappy bird games stepped in lockstep, no gl involved.
+// state is structure of arrays, the step kernel runs 8 games per avx2
+// iteration and the batch is split over the job system. games that end
+// are reset in the same step (their observation is the new start).
+//
+// observations are row major, obs_size floats per game:
+//   bird y, bird vertical speed, next pipe x, gap centre - bird y
+struct bird_env_batch
+{
+  static const int obs_size = 4;
+
+  void create(size_t count, uint32_t seed, const bird_env_config& config = bird_env_config());
+  size_t size() const { return y.size(); }
+
+  void reset(float* obs);
+
+  // actions: non zero flaps. rewards: +1 per pipe passed, -1 on a crash.
+  // dones: 1 when the game ended this step (crash or step limit).
+  void step(const uint8_t* actions, float* obs, float* rewards, uint8_t* dones);
+
+  bird_env_config config;
+  bool  simd = true; //false runs the scalar kernel everywhere, for comparison
+
+  soa_array<float>    y, vy;
+  soa_array<float>    pipe_x, gap_y;
+  soa_array<int32_t>  steps;
+  soa_array<uint32_t> rng;
+  soa_array<float>    score;  //pipes passed this episode
+};
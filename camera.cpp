@@ -0,0 +1,132 @@
+#include "camera.hpp"
+
+#include <atomic>
+#include <glm/ext.hpp>
+
+//shared by every camera, 0 is never handed out
+static std::atomic<unsigned int> last_version{0};
+
+static unsigned int next_version()
+{
+  unsigned int v = last_version.fetch_add(1, std::memory_order_relaxed) + 1;
+  return v ? v : last_version.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+camera::camera() {
+  model      = glm::mat4(1.0);
+  view       = glm::mat4(1.0);
+  projection = glm::mat4(1.0);
+  combined   = glm::mat4(1.0);
+  cameraPos  = glm::vec3(0.0f, 0.0f, z);
+  targetPos  = glm::vec3(0.0f, 0.0f, 0.0f);
+  upVector   = glm::vec3(0.0f, 1.0f, 0.0f);
+}
+
+void camera::set_zoom(float nz)
+{
+  if(nz == z)
+    return;
+
+  z = nz;
+  dirty |= VIEW_DIRTY;
+}
+
+void camera::zoom(float dz)
+{
+  set_zoom(z + dz);
+}
+
+void camera::rotate(float dx, float dy)
+{
+  if(dx == 0 && dy == 0)
+    return;
+
+  xradians += dx;
+  yradians += dy;
+  dirty |= VIEW_DIRTY | MODEL_DIRTY;
+}
+
+void camera::set_rotation(float x, float y)
+{
+  rotate(x - xradians, y - yradians);
+}
+
+void camera::set_fov(float degrees)
+{
+  if(degrees == fov)
+    return;
+
+  fov = degrees;
+  dirty |= PROJECTION_DIRTY;
+}
+
+void camera::set_viewport(viewport v)
+{
+  if(v.x == vp.x && v.y == vp.y && v.w == vp.w && v.h == vp.h)
+    return;
+
+  //aspect is corrected in the vertex shader from u_resolution, so the
+  //projection itself does not depend on the viewport size
+  vp = v;
+  version = next_version();
+}
+
+void camera::update()
+{
+  if(!dirty)
+    return;
+
+  if(dirty & MODEL_DIRTY)
+    model = glm::rotate(glm::mat4(1.0), yradians, glm::vec3(1.0f, 0.0f, 0.0f));
+
+  if(dirty & VIEW_DIRTY)
+  {
+    cameraPos = glm::vec3(0.0f, 0.0f, z);
+    targetPos = glm::vec3(xradians, yradians, 0.0f);
+    upVector  = glm::vec3(0.0f, 1.0f, 0.0f);
+    view      = glm::lookAt(cameraPos, targetPos, upVector);
+  }
+
+  if(dirty & PROJECTION_DIRTY)
+    projection = glm::perspective(glm::radians(fov), 1.f, 0.1f, 100.0f);
+    //projection = glm::ortho(0.0f, 800.0f, 0.0f, 600.0f, -0.1f, 100.0f);
+
+  combined = model * projection * view;
+  dirty    = 0;
+  version = next_version();
+}
+
+const glm::mat4& camera::get_model()
+{
+  update();
+  return model;
+}
+
+const glm::mat4& camera::get_view()
+{
+  update();
+  return view;
+}
+
+const glm::mat4& camera::get_projection()
+{
+  update();
+  return projection;
+}
+
+const glm::mat4& camera::mvp()
+{
+  update();
+  return combined;
+}
+
+bool camera::changed_since(unsigned int& seen_version)
+{
+  update();
+
+  if(seen_version == version)
+    return false;
+
+  seen_version = version;
+  return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+struct viewport
+{
+  int x = 0, y = 0;
+  int w = 0, h = 0;
+};
+
+// lazily evaluated camera. inputs only mark what they invalidate, the
+// matrices are rebuilt on the next read and `version` is bumped so each
+// consumer (uniform slot, culling, ...) can tell whether its copy is stale.
+// versions come from one counter shared by every camera, so a consumer
+// that switches cameras, or sees one recreated, never mistakes the new
+// camera's version for one it already has.
+// several viewports can share one camera and pay for one rebuild.
+struct camera
+{
+  enum dirty_bits : unsigned int
+  {
+    MODEL_DIRTY      = 1 << 0,
+    VIEW_DIRTY       = 1 << 1,
+    PROJECTION_DIRTY = 1 << 2,
+  };
+
+  camera();
+
+  void set_zoom(float z);
+  void zoom(float dz);
+  void rotate(float dx, float dy);
+  void set_rotation(float x, float y);
+  void set_fov(float degrees);
+  void set_viewport(viewport vp);
+
+  const glm::mat4& get_model();
+  const glm::mat4& get_view();
+  const glm::mat4& get_projection();
+  const glm::mat4& mvp();
+
+  // returns true once per change, for consumers that only keep one copy
+  bool changed_since(unsigned int& seen_version);
+
+  void update();
+
+  glm::mat4 model      ;
+  glm::mat4 view       ;
+  glm::mat4 projection ;
+  glm::mat4 combined   ;
+  glm::vec3 cameraPos  ;
+  glm::vec3 targetPos  ;
+  glm::vec3 upVector   ;
+  viewport  vp;
+  float     fov = 60.f;
+  float     z = 4;
+  float     yradians = 0;
+  float     xradians = 0;
+
+  unsigned int dirty   = MODEL_DIRTY | VIEW_DIRTY | PROJECTION_DIRTY;
+  unsigned int version = 0;
+};
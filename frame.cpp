@@ -0,0 +1,20 @@
+#include "frame.hpp"
+
+#include <cstdio>
+
+void latency_stats::add(double latency, double now)
+{
+  sum += latency;
+  max  = latency > max ? latency : max;
+  ++frames;
+
+  if(now - last_report < 1.0)
+    return;
+
+  fprintf(stderr, "%s: %d fps, input-to-present avg %.2f ms, max %.2f ms\n",
+          label, frames, sum / frames * 1000.0, max * 1000.0);
+
+  sum = max = 0;
+  frames = 0;
+  last_report = now;
+}
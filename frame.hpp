@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+
+#include "sim.hpp"
+#include "sprites.hpp"
+
+// everything the renderer needs to draw one frame. the simulation thread
+// fills it and never touches it again once published.
+struct frame_snapshot
+{
+  sim_state prev;
+  sim_state curr;
+  double    tick_time  = 0; //wall clock when `curr` was produced
+  double    tick_dt    = 1.0 / 60.0;
+  double    input_time = 0; //when the input that produced `curr` was sampled
+  long      sequence   = 0;
+
+  //packed from the sprite store at the tick that produced `curr`. slots
+  //are recycled by the triple buffer so the capacity is reused.
+  std::vector<sprite_instance> instances;
+  sprite_bounds                bounds;
+};
+
+// input-to-present latency, reported once per second
+struct latency_stats
+{
+  void add(double latency, double now);
+
+  const char* label = "";
+  double sum = 0, max = 0;
+  double last_report = 0;
+  int    frames = 0;
+};
@@ -0,0 +1,323 @@
+#include "frustum.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "jobs.hpp"
+
+//bounds per job, chunks are compacted into place afterwards
+static const size_t cull_chunk = 16384;
+
+frustum extract_frustum(const glm::mat4& m)
+{
+  //rows of the (column major) matrix
+  glm::vec4 r[4];
+  for(int i = 0; i < 4; ++i)
+    r[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+
+  frustum f;
+  f.planes[0] = r[3] + r[0];
+  f.planes[1] = r[3] - r[0];
+  f.planes[2] = r[3] + r[1];
+  f.planes[3] = r[3] - r[1];
+  f.planes[4] = r[3] + r[2];
+  f.planes[5] = r[3] - r[2];
+
+  //normalised so sphere radii compare in world units
+  for(glm::vec4& p : f.planes)
+  {
+    float len = std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+    if(len > 0)
+      p = p / len;
+  }
+
+  return f;
+}
+
+static inline bool aabb_visible(const frustum& f, float cx, float cy, float cz, float ex, float ey, float ez)
+{
+  for(const glm::vec4& p : f.planes)
+  {
+    float dist   = p.x * cx + p.y * cy + p.z * cz + p.w;
+    float radius = std::fabs(p.x) * ex + std::fabs(p.y) * ey + std::fabs(p.z) * ez;
+    if(dist + radius < 0)
+      return false;
+  }
+  return true;
+}
+
+// appends the set lanes of `mask` as indices starting at `base`
+static inline size_t emit_mask(unsigned int mask, uint32_t base, uint32_t* out)
+{
+  size_t n = 0;
+  while(mask)
+  {
+    out[n++] = base + (uint32_t)__builtin_ctz(mask);
+    mask &= mask - 1;
+  }
+  return n;
+}
+
+#if defined(__AVX__)
+static inline __m256 madd(__m256 a, __m256 b, __m256 c)
+{
+#if defined(__FMA__)
+  return _mm256_fmadd_ps(a, b, c);
+#else
+  return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+
+// flat bounds (sprites) skip the z terms entirely
+template <bool has_z>
+static size_t cull_aabbs_avx(const frustum& f, const aabb_soa& b, size_t& first, size_t end, uint32_t* out)
+{
+  __m256 nx[6], ny[6], nz[6], ax[6], ay[6], az[6], d[6];
+  const __m256 sign = _mm256_set1_ps(-0.f);
+
+  for(int p = 0; p < 6; ++p)
+  {
+    nx[p] = _mm256_set1_ps(f.planes[p].x);
+    ny[p] = _mm256_set1_ps(f.planes[p].y);
+    nz[p] = _mm256_set1_ps(f.planes[p].z);
+    d[p]  = _mm256_set1_ps(f.planes[p].w);
+    ax[p] = _mm256_andnot_ps(sign, nx[p]);
+    ay[p] = _mm256_andnot_ps(sign, ny[p]);
+    az[p] = _mm256_andnot_ps(sign, nz[p]);
+  }
+
+  size_t n = 0;
+  size_t i = first;
+  for(; i + 8 <= end; i += 8)
+  {
+    __m256 cx = _mm256_loadu_ps(b.center_x + i);
+    __m256 cy = _mm256_loadu_ps(b.center_y + i);
+    __m256 ex = _mm256_loadu_ps(b.extent_x + i);
+    __m256 ey = _mm256_loadu_ps(b.extent_y + i);
+
+    //a lane is out once dist + radius < 0 for any plane
+    __m256 out_mask = _mm256_setzero_ps();
+#pragma GCC unroll 6
+    for(int p = 0; p < 6; ++p)
+    {
+      __m256 dist = madd(nx[p], cx, madd(ny[p], cy, d[p]));
+      __m256 rad  = madd(ax[p], ex, _mm256_mul_ps(ay[p], ey));
+
+      if(has_z)
+      {
+        dist = madd(nz[p], _mm256_loadu_ps(b.center_z + i), dist);
+        rad  = madd(az[p], _mm256_loadu_ps(b.extent_z + i), rad);
+      }
+
+      out_mask = _mm256_or_ps(out_mask, _mm256_cmp_ps(_mm256_add_ps(dist, rad), _mm256_setzero_ps(), _CMP_LT_OQ));
+    }
+
+    unsigned int mask = ~(unsigned int)_mm256_movemask_ps(out_mask) & 0xff;
+    if(mask)
+      n += emit_mask(mask, (uint32_t)i, out + n);
+  }
+
+  first = i;
+  return n;
+}
+#endif
+
+static size_t cull_aabbs_range(const frustum& f, const aabb_soa& b, size_t begin, size_t end, uint32_t* out)
+{
+  size_t n = 0;
+  size_t i = begin;
+
+#if defined(__AVX__)
+  if(b.center_z && b.extent_z)
+    n = cull_aabbs_avx<true>(f, b, i, end, out);
+  else
+    n = cull_aabbs_avx<false>(f, b, i, end, out);
+#elif defined(__SSE2__)
+  __m128 nx[6], ny[6], nz[6], ax[6], ay[6], az[6], d[6];
+  const __m128 sign = _mm_set1_ps(-0.f);
+
+  for(int p = 0; p < 6; ++p)
+  {
+    nx[p] = _mm_set1_ps(f.planes[p].x);
+    ny[p] = _mm_set1_ps(f.planes[p].y);
+    nz[p] = _mm_set1_ps(f.planes[p].z);
+    d[p]  = _mm_set1_ps(f.planes[p].w);
+    ax[p] = _mm_andnot_ps(sign, nx[p]);
+    ay[p] = _mm_andnot_ps(sign, ny[p]);
+    az[p] = _mm_andnot_ps(sign, nz[p]);
+  }
+
+  const bool has_z = b.center_z && b.extent_z;
+
+  for(; i + 4 <= end; i += 4)
+  {
+    __m128 cx = _mm_loadu_ps(b.center_x + i);
+    __m128 cy = _mm_loadu_ps(b.center_y + i);
+    __m128 ex = _mm_loadu_ps(b.extent_x + i);
+    __m128 ey = _mm_loadu_ps(b.extent_y + i);
+    __m128 cz = has_z ? _mm_loadu_ps(b.center_z + i) : _mm_setzero_ps();
+    __m128 ez = has_z ? _mm_loadu_ps(b.extent_z + i) : _mm_setzero_ps();
+
+    __m128 out_mask = _mm_setzero_ps();
+    for(int p = 0; p < 6; ++p)
+    {
+      __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[p], cx), _mm_mul_ps(ny[p], cy)),
+                               _mm_add_ps(_mm_mul_ps(nz[p], cz), d[p]));
+      __m128 rad  = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[p], ex), _mm_mul_ps(ay[p], ey)),
+                               _mm_mul_ps(az[p], ez));
+      out_mask = _mm_or_ps(out_mask, _mm_cmplt_ps(_mm_add_ps(dist, rad), _mm_setzero_ps()));
+    }
+
+    unsigned int mask = ~(unsigned int)_mm_movemask_ps(out_mask) & 0xf;
+    n += emit_mask(mask, (uint32_t)i, out + n);
+  }
+#endif
+
+  for(; i < end; ++i)
+  {
+    float cz = b.center_z ? b.center_z[i] : 0.f;
+    float ez = b.extent_z ? b.extent_z[i] : 0.f;
+    if(aabb_visible(f, b.center_x[i], b.center_y[i], cz, b.extent_x[i], b.extent_y[i], ez))
+      out[n++] = (uint32_t)i;
+  }
+
+  return n;
+}
+
+static size_t cull_spheres_range(const frustum& f, const sphere_soa& s, size_t begin, size_t end, uint32_t* out)
+{
+  size_t n = 0;
+  size_t i = begin;
+
+#if defined(__AVX__)
+  __m256 nx[6], ny[6], nz[6], d[6];
+  for(int p = 0; p < 6; ++p)
+  {
+    nx[p] = _mm256_set1_ps(f.planes[p].x);
+    ny[p] = _mm256_set1_ps(f.planes[p].y);
+    nz[p] = _mm256_set1_ps(f.planes[p].z);
+    d[p]  = _mm256_set1_ps(f.planes[p].w);
+  }
+
+  for(; i + 8 <= end; i += 8)
+  {
+    __m256 x = _mm256_loadu_ps(s.x + i);
+    __m256 y = _mm256_loadu_ps(s.y + i);
+    __m256 z = s.z ? _mm256_loadu_ps(s.z + i) : _mm256_setzero_ps();
+    __m256 r = _mm256_loadu_ps(s.radius + i);
+
+    __m256 out_mask = _mm256_setzero_ps();
+    for(int p = 0; p < 6; ++p)
+    {
+      __m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx[p], x), _mm256_mul_ps(ny[p], y)),
+                                  _mm256_add_ps(_mm256_mul_ps(nz[p], z), d[p]));
+      out_mask = _mm256_or_ps(out_mask, _mm256_cmp_ps(_mm256_add_ps(dist, r), _mm256_setzero_ps(), _CMP_LT_OQ));
+    }
+
+    unsigned int mask = ~(unsigned int)_mm256_movemask_ps(out_mask) & 0xff;
+    n += emit_mask(mask, (uint32_t)i, out + n);
+  }
+#elif defined(__SSE2__)
+  __m128 nx[6], ny[6], nz[6], d[6];
+  for(int p = 0; p < 6; ++p)
+  {
+    nx[p] = _mm_set1_ps(f.planes[p].x);
+    ny[p] = _mm_set1_ps(f.planes[p].y);
+    nz[p] = _mm_set1_ps(f.planes[p].z);
+    d[p]  = _mm_set1_ps(f.planes[p].w);
+  }
+
+  for(; i + 4 <= end; i += 4)
+  {
+    __m128 x = _mm_loadu_ps(s.x + i);
+    __m128 y = _mm_loadu_ps(s.y + i);
+    __m128 z = s.z ? _mm_loadu_ps(s.z + i) : _mm_setzero_ps();
+    __m128 r = _mm_loadu_ps(s.radius + i);
+
+    __m128 out_mask = _mm_setzero_ps();
+    for(int p = 0; p < 6; ++p)
+    {
+      __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[p], x), _mm_mul_ps(ny[p], y)),
+                               _mm_add_ps(_mm_mul_ps(nz[p], z), d[p]));
+      out_mask = _mm_or_ps(out_mask, _mm_cmplt_ps(_mm_add_ps(dist, r), _mm_setzero_ps()));
+    }
+
+    unsigned int mask = ~(unsigned int)_mm_movemask_ps(out_mask) & 0xf;
+    n += emit_mask(mask, (uint32_t)i, out + n);
+  }
+#endif
+
+  for(; i < end; ++i)
+  {
+    float z = s.z ? s.z[i] : 0.f;
+    bool inside = true;
+    for(const glm::vec4& p : f.planes)
+      inside = inside && p.x * s.x[i] + p.y * s.y[i] + p.z * z + p.w + s.radius[i] >= 0;
+
+    if(inside)
+      out[n++] = (uint32_t)i;
+  }
+
+  return n;
+}
+
+// every chunk compacts into the front of its own slice of `visible`, then
+// the slices are slid down next to each other. keeps the output ordered
+// without a second buffer.
+template <typename F>
+static size_t cull_chunked(size_t count, uint32_t* visible, const F& cull_range)
+{
+  size_t chunks = (count + cull_chunk - 1) / cull_chunk;
+  std::vector<size_t> counts(chunks);
+
+  jobs.parallel_for(chunks, 1, [&](size_t begin, size_t end) {
+    for(size_t c = begin; c < end; ++c)
+    {
+      size_t first = c * cull_chunk;
+      size_t last  = first + cull_chunk < count ? first + cull_chunk : count;
+      counts[c] = cull_range(first, last, visible + first);
+    }
+  });
+
+  size_t total = 0;
+  for(size_t c = 0; c < chunks; ++c)
+  {
+    if(total != c * cull_chunk)
+      memmove(visible + total, visible + c * cull_chunk, counts[c] * sizeof(uint32_t));
+    total += counts[c];
+  }
+
+  return total;
+}
+
+size_t cull_aabbs(const frustum& f, const aabb_soa& boxes, uint32_t* visible)
+{
+  return cull_chunked(boxes.count, visible, [&](size_t begin, size_t end, uint32_t* out) {
+    return cull_aabbs_range(f, boxes, begin, end, out);
+  });
+}
+
+size_t cull_spheres(const frustum& f, const sphere_soa& spheres, uint32_t* visible)
+{
+  return cull_chunked(spheres.count, visible, [&](size_t begin, size_t end, uint32_t* out) {
+    return cull_spheres_range(f, spheres, begin, end, out);
+  });
+}
+
+size_t cull_aabbs_scalar(const frustum& f, const aabb_soa& b, uint32_t* visible)
+{
+  size_t n = 0;
+  for(size_t i = 0; i < b.count; ++i)
+  {
+    float cz = b.center_z ? b.center_z[i] : 0.f;
+    float ez = b.extent_z ? b.extent_z[i] : 0.f;
+    if(aabb_visible(f, b.center_x[i], b.center_y[i], cz, b.extent_x[i], b.extent_y[i], ez))
+      visible[n++] = (uint32_t)i;
+  }
+  return n;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// six clip planes as (normal, d), a point is inside when dot(n, p) + d >= 0.
+// left, right, bottom, top, near, far.
+struct frustum
+{
+  glm::vec4 planes[6];
+};
+
+// gribb/hartmann extraction, planes come out in the space the matrix maps
+// from (world space for a view-projection, model space for an mvp)
+frustum extract_frustum(const glm::mat4& m);
+
+// structure of arrays bounds. z arrays may be null for flat geometry
+// (sprites), they are treated as 0 then.
+struct aabb_soa
+{
+  const float* center_x = nullptr;
+  const float* center_y = nullptr;
+  const float* center_z = nullptr;
+  const float* extent_x = nullptr;
+  const float* extent_y = nullptr;
+  const float* extent_z = nullptr;
+  size_t count = 0;
+};
+
+struct sphere_soa
+{
+  const float* x = nullptr;
+  const float* y = nullptr;
+  const float* z = nullptr;
+  const float* radius = nullptr;
+  size_t count = 0;
+};
+
+// write the indices of every bound intersecting the frustum to `visible`
+// (room for `count` entries) in ascending order and return how many there
+// are. conservative: boxes near a frustum corner can pass without being
+// inside. vectorised with avx / sse and split over the job system.
+size_t cull_aabbs(const frustum& f, const aabb_soa& boxes, uint32_t* visible);
+size_t cull_spheres(const frustum& f, const sphere_soa& spheres, uint32_t* visible);
+
+// one plane at a time, one box at a time. reference for the benchmark.
+size_t cull_aabbs_scalar(const frustum& f, const aabb_soa& boxes, uint32_t* visible);
@@ -0,0 +1,78 @@
+#include "gpu_cull.hpp"
+
+#include <cstdio>
+
+#include "render_queue.hpp"
+#include "sprites.hpp"
+
+bool gpu_cull::create(unsigned int cull_program)
+{
+  program = cull_program;
+
+  if(!program)
+  {
+    fprintf(stderr, "ERROR: failed to create the cull program\n");
+    return false;
+  }
+
+  glCreateBuffers(1, &commands);
+  glNamedBufferStorage(commands, sizeof(draw_elements_indirect) * max_layers, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+  return true;
+}
+
+void gpu_cull::destroy()
+{
+  glDeleteBuffers(1, &visible);
+  glDeleteBuffers(1, &commands);
+
+  program  = 0;
+  visible  = 0;
+  commands = 0;
+  visible_capacity = 0;
+}
+
+void gpu_cull::run(unsigned int instances, unsigned int first, unsigned int count,
+                   const unsigned int* layer_counts, const unsigned int* layer_starts, int index_count)
+{
+  if(count > visible_capacity)
+  {
+    //gpu only memory, the driver keeps the old one until pending draws finish
+    visible_capacity = visible_capacity ? visible_capacity : 1024;
+    while(visible_capacity < count)
+      visible_capacity *= 2;
+
+    glDeleteBuffers(1, &visible);
+    glCreateBuffers(1, &visible);
+    glNamedBufferStorage(visible, visible_capacity * sizeof(sprite_instance), nullptr, 0);
+  }
+
+  //the cpu only knows the layer ranges, the pass fills in instance counts
+  draw_elements_indirect reset[max_layers] = {};
+  for(int layer = 0; layer < max_layers; ++layer)
+  {
+    if(!layer_counts[layer])
+      continue;
+
+    reset[layer].count         = index_count;
+    reset[layer].base_instance = layer_starts[layer];
+  }
+
+  glNamedBufferSubData(commands, 0, sizeof(reset), reset);
+
+  if(!count)
+    return;
+
+  glUseProgram(program);
+  glProgramUniform1ui(program, 0, first);
+  glProgramUniform1ui(program, 1, count);
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instances);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visible);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commands);
+
+  glDispatchCompute((count + group_size - 1) / group_size, 1, 1);
+
+  //the draw reads both the counts and the compacted instances
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <glad/gl.h>
+
+// frustum culls sprite instances on the gpu. a compute pass reads the
+// streamed instance range, tests every sprite quad against the clip volume
+// of u_mvp and appends survivors to their layer's range of `visible`. the
+// per-layer append counters are the instance counts of an indirect command
+// array, so per-sprite visibility never goes through the cpu.
+struct gpu_cull
+{
+  static const int max_layers = 256;
+  static const int group_size = 256; //matches local_size_x in cull.comp
+
+  // takes the linked cull.comp program, it stays owned by the caller
+  bool create(unsigned int cull_program);
+  void destroy();
+
+  // resets one indexed command per layer (index_count indices starting at
+  // layer_starts[layer]) and culls instances [first, first + count) of the
+  // given buffer into `visible`. frame and view blocks must be bound.
+  void run(unsigned int instances, unsigned int first, unsigned int count,
+           const unsigned int* layer_counts, const unsigned int* layer_starts, int index_count);
+
+  unsigned int program  = 0;
+  unsigned int visible  = 0; //sprite_instance records, grouped by layer
+  unsigned int commands = 0; //draw_elements_indirect[max_layers]
+  size_t visible_capacity = 0;
+};
@@ -0,0 +1,263 @@
+#include "jobs.hpp"
+
+#include <chrono>
+#include <cstdio>
+
+job_system jobs;
+
+static thread_local int tls_index      = -1;
+static thread_local int tls_generation = -1;
+
+bool job_deque::push(job* j)
+{
+  long b = bottom.load(std::memory_order_relaxed);
+  long t = top.load(std::memory_order_acquire);
+
+  if(b - t >= capacity)
+    return false;
+
+  items[b & (capacity - 1)].store(j, std::memory_order_relaxed);
+  bottom.store(b + 1, std::memory_order_release);
+  return true;
+}
+
+job* job_deque::pop()
+{
+  long b = bottom.load(std::memory_order_relaxed) - 1;
+  bottom.store(b, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  long t = top.load(std::memory_order_relaxed);
+
+  if(t > b)
+  {
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  job* j = items[b & (capacity - 1)].load(std::memory_order_relaxed);
+
+  if(t == b)
+  {
+    //last item, race the thieves for it
+    if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+      j = nullptr;
+
+    bottom.store(b + 1, std::memory_order_relaxed);
+  }
+
+  return j;
+}
+
+job* job_deque::steal()
+{
+  long t = top.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  long b = bottom.load(std::memory_order_acquire);
+
+  if(t >= b)
+    return nullptr;
+
+  job* j = items[t & (capacity - 1)].load(std::memory_order_relaxed);
+
+  if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    return nullptr;
+
+  return j;
+}
+
+void job_system::init(int count)
+{
+  if(running.load())
+    shutdown();
+
+  if(count < 0)
+  {
+    count = (int)std::thread::hardware_concurrency() - 1;
+    count = count < 0 ? 0 : count;
+  }
+
+  if(count > max_threads - 4)
+    count = max_threads - 4; //leave room for main/render and friends
+
+  if(!slots)
+    slots = new thread_slot[max_threads];
+
+  for(int i = 0; i < max_threads; ++i)
+  {
+    slots[i].deque.top.store(0);
+    slots[i].deque.bottom.store(0);
+    slots[i].pool_head = 0;
+    slots[i].rng       = 0x9e3779b9u * (i + 1);
+  }
+
+  ++generation;
+  worker_count = count;
+  slot_count.store(count + 1);
+  running.store(true);
+
+  //the caller is slot 0, workers take 1..count
+  tls_index      = 0;
+  tls_generation = generation;
+
+  for(int i = 1; i <= count; ++i)
+    workers.emplace_back(&job_system::worker_main, this, i);
+}
+
+void job_system::shutdown()
+{
+  if(!running.load())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex);
+    running.store(false);
+  }
+  sleep_cv.notify_all();
+
+  for(std::thread& t : workers)
+    t.join();
+
+  workers.clear();
+  worker_count = 0;
+}
+
+int job_system::thread_index()
+{
+  if(tls_generation == generation)
+    return tls_index;
+
+  int index = slot_count.fetch_add(1);
+  if(index >= max_threads)
+  {
+    fprintf(stderr, "ERROR: job system is out of thread slots, running jobs inline\n");
+    index = -1;
+  }
+
+  tls_index      = index;
+  tls_generation = generation;
+  return index;
+}
+
+job* job_system::allocate()
+{
+  thread_slot& slot = slots[tls_index];
+  return &slot.pool[slot.pool_head++ & (pool_size - 1)];
+}
+
+void job_system::execute(job* j)
+{
+  //copy out first, the pool entry may be recycled once we start running
+  job local = *j;
+  local.fn(local.data, local.begin, local.end);
+
+  if(local.counter)
+    local.counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void job_system::run(void (*fn)(void*, size_t, size_t), void* data, size_t begin, size_t end, job_counter* counter)
+{
+  if(counter)
+    counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+  //without workers nothing would take a queued job off the deque until
+  //someone waits on it, fire and forget jobs (texture decodes) would
+  //never start. so they run right here
+  int self = running.load(std::memory_order_relaxed) && worker_count > 0 ? thread_index() : -1;
+
+  //a full deque runs the job inline without touching the pool, a pool
+  //entry is only taken once the push is known to fit. otherwise inline
+  //runs would advance pool_head onto entries that are still queued.
+  //only the owner pushes, so the space seen here can only grow.
+  job_deque* deque = self >= 0 ? &slots[self].deque : nullptr;
+  if(!deque || deque->bottom.load(std::memory_order_relaxed) - deque->top.load(std::memory_order_acquire) >= job_deque::capacity)
+  {
+    job inline_job = {fn, data, begin, end, counter};
+    execute(&inline_job);
+    return;
+  }
+
+  job* j = allocate();
+  j->fn      = fn;
+  j->data    = data;
+  j->begin   = begin;
+  j->end     = end;
+  j->counter = counter;
+
+  deque->push(j);
+
+  pushed.fetch_add(1);
+  if(sleeping.load() > 0)
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex);
+    sleep_cv.notify_all();
+  }
+}
+
+job* job_system::find_job(int self)
+{
+  if(self >= 0)
+  {
+    if(job* j = slots[self].deque.pop())
+      return j;
+  }
+
+  int count = slot_count.load(std::memory_order_relaxed);
+  count = count > max_threads ? max_threads : count;
+
+  //start at a random victim so thieves spread out
+  unsigned& rng = slots[self < 0 ? 0 : self].rng;
+  rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+
+  for(int i = 0; i < count; ++i)
+  {
+    int victim = (int)((rng + i) % count);
+    if(victim == self)
+      continue;
+
+    if(job* j = slots[victim].deque.steal())
+      return j;
+  }
+
+  return nullptr;
+}
+
+void job_system::wait(job_counter* counter)
+{
+  int self = running.load(std::memory_order_relaxed) ? thread_index() : -1;
+
+  while(!counter->done())
+  {
+    job* j = self >= 0 ? find_job(self) : nullptr;
+
+    if(j)
+      execute(j);
+    else
+      std::this_thread::yield();
+  }
+}
+
+void job_system::worker_main(int index)
+{
+  tls_index      = index;
+  tls_generation = generation;
+
+  while(running.load(std::memory_order_relaxed))
+  {
+    unsigned seen = pushed.load();
+
+    if(job* j = find_job(index))
+    {
+      execute(j);
+      continue;
+    }
+
+    //nothing to do, sleep until something is pushed. the timeout only
+    //guards against a missed wakeup, it is not how work is found.
+    std::unique_lock<std::mutex> lock(sleep_mutex);
+    sleeping.fetch_add(1);
+    sleep_cv.wait_for(lock, std::chrono::milliseconds(2), [&] {
+      return pushed.load() != seen || !running.load();
+    });
+    sleeping.fetch_sub(1);
+  }
+}
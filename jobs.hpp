@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// counts unfinished jobs. a job decrements its counter when it is done, so
+// anything that depends on a group of jobs waits for the counter to hit 0.
+struct job_counter
+{
+  std::atomic<int> pending{0};
+
+  bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+struct job
+{
+  void (*fn)(void* data, size_t begin, size_t end);
+  void*        data;
+  size_t       begin, end;
+  job_counter* counter;
+};
+
+// chase-lev deque. the owning thread pushes and pops at the bottom, every
+// other thread steals from the top. fixed capacity, a full deque makes the
+// caller run the job inline instead of growing.
+struct job_deque
+{
+  static const int capacity = 1024;
+
+  bool push(job* j);
+  job* pop();
+  job* steal();
+
+  std::atomic<long> top{0};
+  std::atomic<long> bottom{0};
+  std::atomic<job*> items[capacity];
+};
+
+// one deque and one job pool per thread. worker threads are started by
+// init(), any other thread that submits work (main, render) is given its
+// own slot the first time it calls in and helps out while it waits.
+struct job_system
+{
+  static const int max_threads = 64;
+  static const int pool_size   = job_deque::capacity * 2;
+
+  void init(int worker_count = -1); //-1 = one per core minus the caller
+  void shutdown();
+
+  void run(void (*fn)(void*, size_t, size_t), void* data, size_t begin, size_t end, job_counter* counter);
+  void wait(job_counter* counter);
+
+  // splits [0, count) into chunks of at least `grain` items and calls
+  // f(begin, end) on each, returns once every chunk is done
+  template <typename F>
+  void parallel_for(size_t count, size_t grain, const F& f);
+
+  int thread_count() const { return worker_count + 1; }
+
+  // internals
+  int  thread_index();
+  job* allocate();
+  job* find_job(int self);
+  void execute(job* j);
+  void worker_main(int index);
+
+  struct thread_slot
+  {
+    job_deque deque;
+    job       pool[pool_size];
+    unsigned  pool_head = 0;
+    unsigned  rng       = 0;
+  };
+
+  thread_slot*      slots = nullptr;
+  std::atomic<int>  slot_count{0};
+  int               worker_count = 0;
+  int               generation   = 0; //bumped by init(), invalidates thread slots
+
+  std::vector<std::thread> workers;
+  std::atomic<bool>        running{false};
+  std::atomic<int>         sleeping{0};
+  std::atomic<unsigned>    pushed{0};
+  std::mutex               sleep_mutex;
+  std::condition_variable  sleep_cv;
+};
+
+extern job_system jobs;
+
+template <typename F>
+void job_system::parallel_for(size_t count, size_t grain, const F& f)
+{
+  if(count == 0)
+    return;
+
+  if(grain == 0)
+    grain = 1;
+
+  //a few chunks per thread so stealing can even out uneven work
+  size_t chunks = (size_t)thread_count() * 4;
+  size_t chunk  = (count + chunks - 1) / chunks;
+  chunk = chunk < grain ? grain : chunk;
+
+  if(chunk >= count || !running.load(std::memory_order_relaxed))
+  {
+    f((size_t)0, count);
+    return;
+  }
+
+  auto trampoline = [](void* data, size_t begin, size_t end) {
+    (*(const F*)data)(begin, end);
+  };
+
+  job_counter counter;
+  for(size_t begin = 0; begin < count; begin += chunk)
+  {
+    size_t end = begin + chunk < count ? begin + chunk : count;
+    run(trampoline, (void*)&f, begin, end, &counter);
+  }
+
+  wait(&counter);
+}
@@ -8,73 +8,75 @@
 #include <fstream>
 #include <string>
 #include <cmath>
+#include <atomic>
+#include <chrono>
+#include <thread>
 
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 
-extern "C" {
-  #include <image.h>
-}
+#include "bird_env.hpp"
+#include "camera.hpp"
+#include "frame.hpp"
+#include "jobs.hpp"
+#include "renderer.hpp"
+#include "sim.hpp"
+#include "sprites.hpp"
+#include "triple_buffer.hpp"
 
 #define error(X) fprintf(stderr, "ERROR: %s\n", X)
 
 int window_width  = 800;
 int window_height = 800;
 
-bool loadfile(std::string filepath, std::string& src);
-
 void message_callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, GLchar const* message, void const* user_param);
 
-char elog[2048];
-bool check_shader_program_linkage(unsigned int id);
-void check_shader_compilation(unsigned int id);
-
-float lerp(float a, float b, float t);
-float smoothstep(float x);
-
-unsigned int create_shader_program(std::string vshader_file, std::string fshader_file);
 GLFWwindow* create_opengl_context(int width, int height, bool fullscreen, bool enable_debug);
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 
-struct vertex
+struct options
 {
-  float x, y, z;
-  float r, g, b, a;
-  float u, v;
+  bool fullscreen    = false;
+  bool single_thread = false;
+  bool stats         = false;
+  bool multi_draw    = true;
+  bool gpu_cull      = false;
+  bool cpu_cull      = true;
+  bool color_effect  = false;
+  bool compress      = false; //block compress textures that have no cooked container
+  bool gpu_mips      = false;
+  const char* filter = "pixel";
+  int  sprites       = 1;
+  int  headless      = 0; //games to simulate without a window
+  int  steps         = 10000;
 };
 
-vertex points[] =
-{
- -0.5, 0.5, 0.0,   1.0, 0.0, 0.0, 1.0,   0.0, 0.0,
-  0.5, 0.5, 0.0,   1.0, 0.0, 0.0, 1.0,   0.5, 0.0,
- -0.5,-0.5, 0.0,   0.0, 1.0, 0.0, 1.0,   0.0, 1.0,
-  0.5,-0.5, 0.0,   0.0, 0.0, 1.0, 1.0,   0.5, 1.0,
-};
+options parse_options(int argc, const char* argv[]);
 
-struct camera
-{
-  camera();
-  void reset();
-  glm::mat4 mvp();
-  void update_view_vectors();
-
-  glm::mat4 model      ;
-  glm::mat4 view       ;
-  glm::mat4 projection ;
-  glm::vec3 cameraPos  ;
-  glm::vec3 targetPos  ;
-  glm::vec3 upVector   ;
-  float     z = 4;
-  float     yradians = 0;
-  float     xradians = 0;
-};
+// scroll deltas gathered by the callback until the next tick consumes them
+float scroll_x = 0;
+float scroll_y = 0;
 
-camera cam;
+sim_input poll_input(GLFWwindow* window);
+void spawn_birds(sprite_store& sprites, int count);
+void run_single_threaded(GLFWwindow* window, const options& opts);
+void run_threaded(GLFWwindow* window, const options& opts);
+void run_headless(const options& opts);
 
 int main(int argc, const char* argv[])
 {
-  GLFWwindow* window = create_opengl_context(window_width, window_height, (argc > 1), true);
+  options opts = parse_options(argc, argv);
+
+  if(opts.headless > 0)
+  {
+    jobs.init();
+    run_headless(opts);
+    jobs.shutdown();
+    return 0;
+  }
+
+  GLFWwindow* window = create_opengl_context(window_width, window_height, opts.fullscreen, true);
 
   if(!window)
   {
@@ -85,197 +87,295 @@ int main(int argc, const char* argv[])
 
   glfwSetScrollCallback(window, scroll_callback);
 
-  unsigned int prg = create_shader_program("./shaders/shader.vert", "./shaders/shader.frag");
-
-  int mvp_loc = glGetUniformLocation(prg, "u_mvp");
-  int res_loc = glGetUniformLocation(prg, "u_resolution");
-  int u_time  = glGetUniformLocation(prg, "u_time");
-  int u_tex0  = glGetUniformLocation(prg, "u_tex0");
-  int u_tex1  = glGetUniformLocation(prg, "u_tex1");
-
-  unsigned int buffer;
-  glCreateBuffers(1, &buffer);
-  glNamedBufferData(buffer, sizeof(vertex) * 4, points, GL_STATIC_DRAW);
-  //glNamedBufferStorage(vbo, sizeof(vertex)*vertex_count, vertices, GL_DYNAMIC_STORAGE_BIT);
-
-  unsigned int vao;
-  glCreateVertexArrays(1, &vao);
-
-  glVertexArrayVertexBuffer(vao, 0, buffer, 0, sizeof(vertex));
+  jobs.init();
 
-  glEnableVertexArrayAttrib(vao, 0);
-  glEnableVertexArrayAttrib(vao, 1);
-  glEnableVertexArrayAttrib(vao, 2);
+  if(opts.single_thread)
+    run_single_threaded(window, opts);
+  else
+    run_threaded(window, opts);
 
-  glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
-  glVertexArrayAttribFormat(vao, 1, 4, GL_FLOAT, GL_FALSE, offsetof(vertex, r));
-  glVertexArrayAttribFormat(vao, 2, 2, GL_FLOAT, GL_FALSE, offsetof(vertex, u));
-
-  glVertexArrayAttribBinding(vao, 0, 0);
-  glVertexArrayAttribBinding(vao, 1, 0);
-  glVertexArrayAttribBinding(vao, 2, 0);
-
-  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-  Image img;
-  Image_load(&img, "./bird64.png");
+  jobs.shutdown();
+  glfwTerminate();
+    
+  return 0;
+}
 
-  Image bg_img;
-  Image_load(&bg_img, "./background.png");
+options parse_options(int argc, const char* argv[])
+{
+  options opts;
 
-  if(!img.data || !bg_img.data)
+  for(int i = 1; i < argc; ++i)
   {
-    error("failed to load bird64.png or bg_img");
+    std::string arg = argv[i];
+
+    if(arg == "--single-thread")
+      opts.single_thread = true;
+    else if(arg == "--stats")
+      opts.stats = true;
+    else if(arg == "--no-multi-draw")
+      opts.multi_draw = false;
+    else if(arg == "--gpu-cull")
+      opts.gpu_cull = true;
+    else if(arg == "--no-cull")
+      opts.cpu_cull = false;
+    else if(arg == "--gpu-mips")
+      opts.gpu_mips = true;
+    else if(arg == "--filter" && i + 1 < argc)
+      opts.filter = argv[++i];
+    else if(arg == "--compress-textures")
+      opts.compress = true;
+    else if(arg == "--color-effect")
+      opts.color_effect = true;
+    else if(arg == "--headless" && i + 1 < argc)
+      opts.headless = atoi(argv[++i]);
+    else if(arg == "--steps" && i + 1 < argc)
+      opts.steps = atoi(argv[++i]);
+    else if(arg == "--sprites" && i + 1 < argc)
+      opts.sprites = atoi(argv[++i]);
+    else
+      opts.fullscreen = true; //any other argument keeps meaning fullscreen
   }
 
-  unsigned int texture;
-  glCreateTextures(GL_TEXTURE_2D, 1, &texture);
-  glBindTextureUnit(0, texture);
-
-  glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_REPEAT );
-  glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_REPEAT );
-  glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-  glTextureStorage2D(texture, 1, GL_RGBA8, img.w, img.h);
-  glTextureSubImage2D(texture, 0, 0, 0, img.w, img.h, GL_RGBA, GL_UNSIGNED_BYTE, img.data);
+  return opts;
+}
 
-  unsigned int background;
-  glCreateTextures(GL_TEXTURE_2D, 1, &background);
-  glBindTextureUnit(1, background);
+sim_input poll_input(GLFWwindow* window)
+{
+  if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+  {
+    glfwSetWindowShouldClose(window, 1);
+  }
 
-  glTextureParameteri(background, GL_TEXTURE_WRAP_S, GL_REPEAT );
-  glTextureParameteri(background, GL_TEXTURE_WRAP_T, GL_REPEAT );
-  glTextureParameteri(background, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTextureParameteri(background, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  sim_input input;
+  input.zoom_in  = glfwGetKey(window, GLFW_KEY_W);
+  input.zoom_out = !input.zoom_in && glfwGetKey(window, GLFW_KEY_S);
+  //the accumulators are only cleared once a tick has used them, a loop
+  //iteration without ticks keeps them for the next one
+  input.scroll_x = scroll_x;
+  input.scroll_y = scroll_y;
+  return input;
+}
 
-  glTextureStorage2D(background, 1, GL_RGBA8, bg_img.w, bg_img.h);
-  glTextureSubImage2D(background, 0, 0, 0, bg_img.w, bg_img.h, GL_RGBA, GL_UNSIGNED_BYTE, bg_img.data);
+// a single bird keeps the original full size quad at the origin, more are
+// scattered around and fly about for stress testing
+void spawn_birds(sprite_store& sprites, int count)
+{
+  sprites.reserve(count);
 
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  if(count == 1)
+  {
+    sprites.create(sprite_desc());
+    return;
+  }
 
-  float currentTime = glfwGetTime();
-  float time = 0;
+  for(int i = 0; i < count; ++i)
+  {
+    sprite_desc d;
+    d.x  = rand() / (float)RAND_MAX * 8 - 4;
+    d.y  = rand() / (float)RAND_MAX * 8 - 4;
+    d.vx = rand() / (float)RAND_MAX * 2 - 1;
+    d.vy = rand() / (float)RAND_MAX * 2 - 1;
+    d.sx = d.sy = 0.1f;
+    d.frame = rand() % sprite_frames;
+    d.layer = rand() % 4;
+    sprites.create(d);
+  }
+}
 
-  float fps_time = 0;
-  int fps = 0;
-  bool recording = false;
-  float atime = 0;
+// the original loop: input, simulation, gl submission and the vsync'd swap
+// all on the main thread. kept as the latency baseline.
+void run_single_threaded(GLFWwindow* window, const options& opts)
+{
+  renderer gfx;
+  gfx.assets.compress = opts.compress;
+  gfx.assets.gpu_mips = opts.gpu_mips;
+  if(!parse_sampler_preset(opts.filter, gfx.sprite_sampling))
+    fprintf(stderr, "ERROR: unknown --filter %s, using trilinear\n", opts.filter);
+  gfx.init();
+  gfx.print_stats = opts.stats;
+  gfx.queue.multi_draw = opts.multi_draw;
+  gfx.gpu_culling      = opts.gpu_cull;
+  gfx.cpu_culling      = opts.cpu_cull;
+  if(opts.color_effect)
+    gfx.sprite_features |= SPRITE_COLOR_EFFECT;
+  glfwSwapInterval(1); //vsync on
+
+  latency_stats latency;
+  latency.label = "single-thread";
+
+  sprite_store sprites;
+  spawn_birds(sprites, opts.sprites);
+
+  fixed_timestep stepper(60.0, 5);
+  frame_snapshot snap;
+  snap.prev.cam_z = snap.curr.cam_z = gfx.cam.z;
+  snap.instances.resize(sprites.size());
+  sprites_pack_instances(sprites, snap.instances.data());
+  sprites_pack_bounds(sprites, snap.bounds);
+
+  double currentTime = glfwGetTime();
 
   while(!glfwWindowShouldClose(window))
   {
-    float dt    = glfwGetTime() - currentTime;
+    double dt   = glfwGetTime() - currentTime;
     currentTime = glfwGetTime();
 
-    time += dt;
-    fps_time += dt;
+    sim_input input  = poll_input(window);
+    double input_time = glfwGetTime();
 
-    if(time >= 0.6)
+    //the simulation runs at a fixed rate whatever the display does, the
+    //frame is drawn from a blend of the last two ticks
+    int ticks = stepper.advance(dt);
+    for(int i = 0; i < ticks; ++i)
     {
-      for(int i = 0; i < 4; ++i)
-        points[i].u += 0.5;
-
-      time = 0;
+      snap.prev = snap.curr;
+      sim_step(snap.curr, input, stepper.tick_dt);
+      sprites_update(sprites, stepper.tick_dt);
     }
 
-    glNamedBufferData(buffer, sizeof(vertex) * 4, points, GL_STATIC_DRAW);
-
-    ++fps;
-    if(fps_time >= 1.f)
-    {
-      //std::cout << "fps: " << fps << "\n";
-      fps_time -= 1;
-      fps=0;
-    }
-    
-    if(recording)
+    if(ticks > 0)
     {
-      Image img;
-      Image_alloc(&img, window_width, window_height, 4);
-
-      glReadPixels(0, 0, img.w, img.h, GL_RGBA, GL_UNSIGNED_BYTE, img.data); //nice trick
-
-      Image_flip_y(img);
-      std::cout.write((const char*)img.data, img.w * img.h * img.c);
-      //Image_save(img, "screenshot.png");
-      //Image_free(&img);
+      scroll_x = scroll_y = 0;
+      snap.instances.resize(sprites.size());
+      sprites_pack_instances(sprites, snap.instances.data());
+      sprites_pack_bounds(sprites, snap.bounds);
     }
 
-    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-    {
-      glfwSetWindowShouldClose(window, 1);
-    }
+    gfx.draw(snap, stepper.alpha());
 
-    if(glfwGetKey(window, GLFW_KEY_W)) {
-      atime += dt;
-      cam.z -= lerp(0, 1.5, smoothstep(atime)) * dt;//1.5 is max velocity of the camera
-    } else if(glfwGetKey(window, GLFW_KEY_S)) {
-      atime += dt;
-      cam.z += lerp(0, 1.5, smoothstep(atime)) * dt;
-    } else {
-      atime = 0;
-    }
-
-    glBindTextureUnit(0, texture);
-    glBindTextureUnit(1, background);
-
-    glUseProgram(prg);
+    glfwPollEvents();
+    glfwSwapBuffers(window);
 
-    glUniform1i(u_tex0, 0);
-    glUniform1i(u_tex1, 1);
+    if(opts.stats && ticks > 0)
+      latency.add(glfwGetTime() - input_time, glfwGetTime());
+  }
 
+  gfx.shutdown();
+}
 
-    cam.reset();
-    cam.update_view_vectors();
-    cam.model      = glm::rotate(cam.model, cam.yradians , glm::vec3(1.0f, 0.0f, 0.0f));
-    cam.view       = glm::lookAt(cam.cameraPos, cam.targetPos, cam.upVector);
-    cam.projection = glm::perspective(glm::radians(60.f), 1.f, 0.1f, 100.0f);
-    //projection = glm::ortho(0.0f, 800.0f, 0.0f, 600.0f, -0.1f, 100.0f);
+struct render_shared
+{
+  triple_buffer<frame_snapshot> frames;
+  std::atomic<bool> quit{false};
+};
 
-    glm::mat4 mvp = cam.mvp();
-    glUniformMatrix4fv(mvp_loc,1, GL_FALSE, glm::value_ptr(mvp));
+// owns the gl context for its whole life and only ever reads published
+// snapshots, so a blocking swap never holds up input or simulation
+void render_thread(GLFWwindow* window, render_shared* shared, options opts)
+{
+  glfwMakeContextCurrent(window);
+  glfwSwapInterval(1); //vsync on
+
+  renderer gfx;
+  gfx.assets.compress = opts.compress;
+  gfx.assets.gpu_mips = opts.gpu_mips;
+  if(!parse_sampler_preset(opts.filter, gfx.sprite_sampling))
+    fprintf(stderr, "ERROR: unknown --filter %s, using trilinear\n", opts.filter);
+  gfx.init();
+  gfx.print_stats = opts.stats;
+  gfx.queue.multi_draw = opts.multi_draw;
+  gfx.gpu_culling      = opts.gpu_cull;
+  gfx.cpu_culling      = opts.cpu_cull;
+  if(opts.color_effect)
+    gfx.sprite_features |= SPRITE_COLOR_EFFECT;
+
+  latency_stats latency;
+  latency.label = "threaded";
+
+  long last_sequence = -1;
+
+  while(!shared->quit.load(std::memory_order_acquire))
+  {
+    shared->frames.acquire();
+    const frame_snapshot& snap = shared->frames.read_slot();
 
-    glUniform2f(res_loc, window_width, window_height);
-    glUniform1f(u_time, glfwGetTime());
+    //curr is one tick ahead of the wall clock, blend towards it
+    double alpha = (glfwGetTime() - snap.tick_time) / snap.tick_dt;
+    alpha = alpha < 0 ? 0 : alpha > 1 ? 1 : alpha;
 
-    glClearColor(0.2, 0.2, 0.2, 1.f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    gfx.draw(snap, alpha);
+    glfwSwapBuffers(window);
 
-      //bind texture 
-      glBindVertexArray(vao);
-      glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    if(opts.stats && snap.sequence != last_sequence && snap.sequence > 0)
+      latency.add(glfwGetTime() - snap.input_time, glfwGetTime());
 
-    glfwPollEvents();
-    glfwSwapInterval(1); //vsync on
-    glfwSwapBuffers(window);
+    last_sequence = snap.sequence;
   }
 
-  Image_free(&img);
-  glfwTerminate();
-    
-  return 0;
+  gfx.shutdown();
+  glfwMakeContextCurrent(nullptr);
 }
 
-bool loadfile(std::string filepath, std::string& src)
+// the main thread keeps glfw event handling (glfw requires it) and the
+// fixed-rate simulation, and hands the gl context to the render thread
+void run_threaded(GLFWwindow* window, const options& opts)
 {
-  std::ifstream file(filepath, std::fstream::binary);
-  std::string line;
+  render_shared shared;
+
+  sprite_store sprites;
+  spawn_birds(sprites, opts.sprites);
 
-  src = "";
+  fixed_timestep stepper(60.0, 5);
+  sim_state prev, curr;
+  curr.cam_z = prev.cam_z = camera().z;
 
-  if(!file.is_open())
   {
-    error("failed to load file from specified path");
-    return false;
+    frame_snapshot& first = shared.frames.write_slot();
+    first.prev = prev;
+    first.curr = curr;
+    first.tick_time = glfwGetTime();
+    first.tick_dt   = stepper.tick_dt;
+    first.instances.resize(sprites.size());
+    sprites_pack_instances(sprites, first.instances.data());
+    sprites_pack_bounds(sprites, first.bounds);
+    shared.frames.publish();
   }
 
-  while(std::getline(file, line))
+  glfwMakeContextCurrent(nullptr);
+  std::thread renderer_thread(render_thread, window, &shared, opts);
+
+  long   sequence    = 0;
+  double currentTime = glfwGetTime();
+
+  while(!glfwWindowShouldClose(window))
   {
-    src += line;
+    double dt   = glfwGetTime() - currentTime;
+    currentTime = glfwGetTime();
+
+    sim_input input  = poll_input(window);
+    double input_time = glfwGetTime();
+
+    int ticks = stepper.advance(dt);
+    for(int i = 0; i < ticks; ++i)
+    {
+      prev = curr;
+      sim_step(curr, input, stepper.tick_dt);
+      sprites_update(sprites, stepper.tick_dt);
+    }
+
+    if(ticks > 0)
+    {
+      scroll_x = scroll_y = 0;
+      frame_snapshot& snap = shared.frames.write_slot();
+      snap.prev       = prev;
+      snap.curr       = curr;
+      snap.tick_time  = glfwGetTime();
+      snap.tick_dt    = stepper.tick_dt;
+      snap.input_time = input_time;
+      snap.sequence   = ++sequence;
+      snap.instances.resize(sprites.size());
+      sprites_pack_instances(sprites, snap.instances.data());
+      sprites_pack_bounds(sprites, snap.bounds);
+      shared.frames.publish();
+    }
+
+    //sleep until the next tick is due, input events wake us up early
+    double wait = stepper.tick_dt - stepper.accumulator;
+    glfwWaitEventsTimeout(wait > 0 ? wait : 0);
   }
 
-  return true;
+  shared.quit.store(true, std::memory_order_release);
+  renderer_thread.join();
 }
 
 void message_callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, GLchar const* message, void const* user_param)
@@ -316,84 +416,6 @@ void message_callback(GLenum source, GLenum type, GLuint id, GLenum severity, GL
 	std::cout << src_str << ", " << type_str << ", " << severity_str << ", " << id << ": " << message << '\n';
 }
 
-void check_shader_compilation(unsigned int id)
-{
-  glCompileShader(id);
-
-  int status = -1;
-  glGetShaderiv(id, GL_COMPILE_STATUS, &status);
-
-  if(status == GL_FALSE)
-  {
-     int logsize = 0;
-     glGetShaderiv(id, GL_INFO_LOG_LENGTH, &logsize);
-     glGetShaderInfoLog(id, logsize, &logsize, elog);
-     fprintf(stderr, "SHADER ERROR: %s\n", elog);
-  }
-}
-
-bool check_shader_program_linkage(unsigned int id) {
-
-  int lparams = -1;
-  glGetProgramiv(id, GL_LINK_STATUS, &lparams);
-
-  if(GL_TRUE == lparams)
-    return true;
-
-  fprintf(stderr, "failed to link shader program with GL index %u\n", id);
-
-  const int max_length = 2048;
-  int actual_length    = 0;
-
-  glGetProgramInfoLog(id, max_length, &actual_length, elog);
-  fprintf(stderr, "program info log for program with GL index %u\n\t%s", id, elog);
-
-  glDeleteProgram(id);
-  return false;
-}
-
-float lerp(float a, float b, float t)
-{
-  return (b-a)*t + a;
-}
-
-float smoothstep(float x)
-{
-  return (x <= 0)? 0 : (x >= 1)? 1 : (6*pow(x, 2)-5*pow(x, 3));
-}
-
-unsigned int create_shader_program(std::string vshader_file, std::string fshader_file)
-{
-  //load shaders && create program
-  std::string vs_srcfile, fs_srcfile;
-  loadfile(vshader_file, vs_srcfile);
-  loadfile(fshader_file, fs_srcfile);
-
-  const char* vs_src = vs_srcfile.data();
-  const char* fs_src = fs_srcfile.data();
-
-  unsigned int vs, fs, prg;
-  vs = glCreateShader(GL_VERTEX_SHADER);
-  glShaderSource(vs, 1, &vs_src, NULL);
-  glCompileShader(vs);
-  check_shader_compilation(vs);
-
-  fs = glCreateShader(GL_FRAGMENT_SHADER);
-  glShaderSource(fs, 1, &fs_src, NULL);
-  glCompileShader(fs);
-  check_shader_compilation(fs);
-
-  prg = glCreateProgram();
-  glAttachShader(prg, vs);
-  glAttachShader(prg, fs);
-  glLinkProgram(prg);
-  check_shader_program_linkage(prg);
-
-  glDeleteShader(vs);
-  glDeleteShader(fs);
-  return prg;
-}
-
 GLFWwindow* create_opengl_context(int width, int height, bool fullscreen, bool enable_debug)
 {
   if(!glfwInit())
@@ -443,35 +465,51 @@ GLFWwindow* create_opengl_context(int width, int height, bool fullscreen, bool e
   return window;
 }
 
-void camera::reset() {
-  model      = glm::mat4(1.0);
-  view       = glm::mat4(1.0);
-  projection = glm::mat4(1.0);
-}
-
-camera::camera() {
-  model      = glm::mat4(1.0);
-  view       = glm::mat4(1.0);
-  projection = glm::mat4(1.0);
-  cameraPos  = glm::vec3(0.0f, 0.0f, z);
-  targetPos  = glm::vec3(0.0f, 0.0f, 0.0f);
-  upVector   = glm::vec3(0.0f, 1.0f, 0.0f);
-}
-
-void camera::update_view_vectors()
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
-  cameraPos  = glm::vec3(0.0f, 0.0f, z);
-  targetPos  = glm::vec3(xradians, yradians, 0.0f);
-  upVector   = glm::vec3(0.0f, 1.0f, 0.0f);
+  scroll_x += xoffset;
+  scroll_y += yoffset;
 }
 
-glm::mat4 camera::mvp()
+// steps the batched bird games with a fixed policy reading the observations
+// and reports throughput. no window, no gl context.
+void run_headless(const options& opts)
 {
-  return model * projection * view ;
-}
+  size_t games = opts.headless;
 
-void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
-{
-  cam.yradians += yoffset * 18.f / 60.f;
-  cam.xradians -= xoffset * 18.f / 60.f;
+  bird_env_batch env;
+  env.create(games, 1234);
+
+  std::vector<float>   obs(games * bird_env_batch::obs_size), rewards(games);
+  std::vector<uint8_t> dones(games), actions(games);
+
+  env.reset(obs.data());
+
+  auto   start = std::chrono::steady_clock::now();
+  double pipes = 0;
+  long   episodes = 0;
+
+  for(int s = 0; s < opts.steps; ++s)
+  {
+    //flap when under the gap and falling
+    for(size_t i = 0; i < games; ++i)
+    {
+      const float* o = &obs[i * bird_env_batch::obs_size];
+      actions[i] = o[3] > 0.05f && o[1] < 0;
+    }
+
+    env.step(actions.data(), obs.data(), rewards.data(), dones.data());
+
+    for(size_t i = 0; i < games; ++i)
+    {
+      pipes    += rewards[i] > 0;
+      episodes += dones[i];
+    }
+  }
+
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  printf("%zu games x %d steps in %.2f s: %.1f M steps/s, %ld episodes, %.1f pipes per episode\n",
+         games, opts.steps, elapsed, games * (double)opts.steps / elapsed / 1e6,
+         episodes, episodes ? pipes / episodes : pipes);
 }
@@ -0,0 +1,244 @@
+#include "mipmap.hpp"
+
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+// 8 bit srgb to linear, and linear back through a table fine enough that
+// the darkest steps (where srgb is steepest) stay within a quarter unit
+struct srgb_tables
+{
+  static const int encode_size = 16384;
+
+  float   to_linear[256];
+  uint8_t to_srgb[encode_size];
+
+  srgb_tables()
+  {
+    for(int i = 0; i < 256; ++i)
+    {
+      float c = i / 255.f;
+      to_linear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    for(int i = 0; i < encode_size; ++i)
+    {
+      float l = i / (float)(encode_size - 1);
+      float c = l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.f / 2.4f) - 0.055f;
+      to_srgb[i] = (uint8_t)(c * 255.f + 0.5f);
+    }
+  }
+
+  uint8_t encode(float l) const
+  {
+    int i = (int)(l * (encode_size - 1) + 0.5f);
+    return to_srgb[i < 0 ? 0 : (i >= encode_size ? encode_size - 1 : i)];
+  }
+};
+
+static const srgb_tables& tables()
+{
+  static const srgb_tables t;
+  return t;
+}
+
+void srgb_to_linear_premultiplied(const uint8_t* rgba, size_t count, float* out)
+{
+  const srgb_tables& t = tables();
+
+  for(size_t i = 0; i < count; ++i)
+  {
+    float a = rgba[i * 4 + 3] / 255.f;
+    out[i * 4 + 0] = t.to_linear[rgba[i * 4 + 0]] * a;
+    out[i * 4 + 1] = t.to_linear[rgba[i * 4 + 1]] * a;
+    out[i * 4 + 2] = t.to_linear[rgba[i * 4 + 2]] * a;
+    out[i * 4 + 3] = a;
+  }
+}
+
+void linear_premultiplied_to_srgb(const float* in, size_t count, uint8_t* rgba)
+{
+  const srgb_tables& t = tables();
+
+  for(size_t i = 0; i < count; ++i)
+  {
+    float a   = in[i * 4 + 3];
+    float inv = a > 1e-6f ? 1.f / a : 0.f;
+
+    for(int c = 0; c < 3; ++c)
+      rgba[i * 4 + c] = t.encode(in[i * 4 + c] * inv);
+
+    int alpha = (int)(a * 255.f + 0.5f);
+    rgba[i * 4 + 3] = (uint8_t)(alpha < 0 ? 0 : (alpha > 255 ? 255 : alpha));
+  }
+}
+
+static int half(int v)
+{
+  return v > 1 ? v / 2 : 1;
+}
+
+void downsample_box(const float* src, int width, int height, float* dst, bool simd)
+{
+  int mw = half(width), mh = half(height);
+
+  for(int y = 0; y < mh; ++y)
+  {
+    const float* r0 = src + (size_t)(2 * y < height ? 2 * y : height - 1) * width * 4;
+    const float* r1 = src + (size_t)(2 * y + 1 < height ? 2 * y + 1 : height - 1) * width * 4;
+    float* out = dst + (size_t)y * mw * 4;
+
+    int x = 0;
+
+#if defined(__AVX__)
+    //two output texels per step, each register holds two rgba texels
+    const __m256 quarter = _mm256_set1_ps(0.25f);
+
+    for(; simd && 2 * x + 3 < width; x += 2)
+    {
+      __m256 a = _mm256_add_ps(_mm256_loadu_ps(r0 + x * 8), _mm256_loadu_ps(r1 + x * 8));
+      __m256 b = _mm256_add_ps(_mm256_loadu_ps(r0 + x * 8 + 8), _mm256_loadu_ps(r1 + x * 8 + 8));
+
+      __m256 lo = _mm256_permute2f128_ps(a, b, 0x20);
+      __m256 hi = _mm256_permute2f128_ps(a, b, 0x31);
+
+      _mm256_storeu_ps(out + x * 4, _mm256_mul_ps(_mm256_add_ps(lo, hi), quarter));
+    }
+#endif
+
+    for(; x < mw; ++x)
+    {
+      int x0 = 2 * x < width ? 2 * x : width - 1;
+      int x1 = 2 * x + 1 < width ? 2 * x + 1 : width - 1;
+
+      for(int c = 0; c < 4; ++c)
+        out[x * 4 + c] = (r0[x0 * 4 + c] + r0[x1 * 4 + c] + r1[x0 * 4 + c] + r1[x1 * 4 + c]) * 0.25f;
+    }
+  }
+}
+
+// taps at -2.5 .. 2.5 source texels around each output texel centre
+struct kaiser_taps
+{
+  float w[6];
+
+  kaiser_taps()
+  {
+    const float beta = 4.f;
+    const float pi   = 3.14159265f;
+    auto i0 = [](float x) {
+      float sum = 1, term = 1;
+      for(int k = 1; k < 12; ++k)
+      {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum  += term;
+      }
+      return sum;
+    };
+
+    float total = 0;
+    for(int i = 0; i < 6; ++i)
+    {
+      float d    = i - 2.5f;
+      float x    = d / 2.f;                 //sinc at half the source rate
+      float sinc = sinf(pi * x) / (pi * x);
+      float r    = d / 3.f;
+      w[i]  = sinc * i0(beta * sqrtf(1 - r * r)) / i0(beta);
+      total += w[i];
+    }
+
+    for(float& v : w)
+      v /= total;
+  }
+};
+
+void downsample_kaiser(const float* src, int width, int height, float* dst)
+{
+  static const kaiser_taps taps;
+  int mw = half(width), mh = half(height);
+
+  //horizontal into (mw x height), then vertical into dst
+  std::vector<float> tmp((size_t)mw * height * 4);
+
+  for(int y = 0; y < height; ++y)
+  {
+    const float* row = src + (size_t)y * width * 4;
+    float* out = &tmp[(size_t)y * mw * 4];
+
+    for(int x = 0; x < mw; ++x)
+    {
+      float acc[4] = {};
+
+      for(int t = 0; t < 6; ++t)
+      {
+        int sx = width > 1 ? 2 * x - 2 + t : 0;
+        sx = sx < 0 ? 0 : (sx >= width ? width - 1 : sx);
+
+        for(int c = 0; c < 4; ++c)
+          acc[c] += row[sx * 4 + c] * taps.w[t];
+      }
+
+      for(int c = 0; c < 4; ++c)
+        out[x * 4 + c] = acc[c];
+    }
+  }
+
+  for(int y = 0; y < mh; ++y)
+  {
+    float* out = dst + (size_t)y * mw * 4;
+
+    for(size_t i = 0; i < (size_t)mw * 4; ++i)
+      out[i] = 0;
+
+    for(int t = 0; t < 6; ++t)
+    {
+      int sy = height > 1 ? 2 * y - 2 + t : 0;
+      sy = sy < 0 ? 0 : (sy >= height ? height - 1 : sy);
+
+      const float* row = &tmp[(size_t)sy * mw * 4];
+      for(size_t i = 0; i < (size_t)mw * 4; ++i)
+        out[i] += row[i] * taps.w[t];
+    }
+
+    //the negative lobes can overshoot, keep colour within its alpha
+    for(int x = 0; x < mw; ++x)
+    {
+      float a = out[x * 4 + 3];
+      a = a < 0 ? 0 : (a > 1 ? 1 : a);
+      out[x * 4 + 3] = a;
+
+      for(int c = 0; c < 3; ++c)
+        out[x * 4 + c] = out[x * 4 + c] < 0 ? 0 : (out[x * 4 + c] > a ? a : out[x * 4 + c]);
+    }
+  }
+}
+
+void build_mip_chain(const uint8_t* rgba, int width, int height, std::vector<std::vector<uint8_t>>& mips, mip_filter filter)
+{
+  mips.clear();
+
+  std::vector<float> level((size_t)width * height * 4), next;
+  srgb_to_linear_premultiplied(rgba, (size_t)width * height, level.data());
+
+  int w = width, h = height;
+
+  while(w > 1 || h > 1)
+  {
+    int mw = half(w), mh = half(h);
+    next.resize((size_t)mw * mh * 4);
+
+    if(filter == MIP_KAISER)
+      downsample_kaiser(level.data(), w, h, next.data());
+    else
+      downsample_box(level.data(), w, h, next.data());
+
+    mips.emplace_back((size_t)mw * mh * 4);
+    linear_premultiplied_to_srgb(next.data(), (size_t)mw * mh, mips.back().data());
+
+    level.swap(next);
+    w = mw;
+    h = mh;
+  }
+}
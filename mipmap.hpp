@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum mip_filter
+{
+  MIP_BOX,     //2x2 average
+  MIP_KAISER,  //6 tap kaiser windowed sinc, sharper at small levels
+};
+
+// full chain below level 0 of an srgb rgba8 image, level 0 excluded. the
+// filtering runs in linear light on premultiplied alpha, so levels keep
+// their brightness and transparent texels do not bleed dark fringes, and
+// every level is computed from the float result of the one above it.
+// odd sizes clamp at the edge.
+void build_mip_chain(const uint8_t* rgba, int width, int height, std::vector<std::vector<uint8_t>>& mips,
+                     mip_filter filter = MIP_BOX);
+
+// linear premultiplied rgba floats in and out, one 2:1 step. `simd`
+// picks the avx path where it is compiled in, the bench compares both
+void downsample_box(const float* src, int width, int height, float* dst, bool simd = true);
+void downsample_kaiser(const float* src, int width, int height, float* dst);
+
+void srgb_to_linear_premultiplied(const uint8_t* rgba, size_t count, float* out);
+void linear_premultiplied_to_srgb(const float* in, size_t count, uint8_t* rgba);
@@ -0,0 +1,204 @@
+#include "program_cache.hpp"
+
+#include <glad/gl.h>
+
+#include <cstdio>
+#include <vector>
+#include <sys/stat.h>
+
+program_cache shader_cache;
+
+static const uint32_t cache_magic   = 0x42504e47; //"GNPB"
+static const uint32_t cache_version = 1;
+
+struct cache_header
+{
+  uint32_t magic;
+  uint32_t version;
+  uint64_t key;
+  uint32_t format;
+  uint32_t length;
+};
+
+uint64_t hash_bytes(const void* data, size_t size, uint64_t seed)
+{
+  const unsigned char* p = (const unsigned char*)data;
+  uint64_t h = seed;
+
+  for(size_t i = 0; i < size; ++i)
+  {
+    h ^= p[i];
+    h *= 0x100000001b3ull;
+  }
+
+  return h;
+}
+
+static std::string gl_string(GLenum name)
+{
+  const char* s = (const char*)glGetString(name);
+  return s ? s : "";
+}
+
+bool program_cache::init(const std::string& directory)
+{
+  dir = directory;
+  if(!dir.empty() && dir.back() != '/')
+    dir += '/';
+
+  GLint formats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+  if(formats <= 0)
+  {
+    fprintf(stderr, "shader cache: driver has no program binary formats, disabled\n");
+    enabled = false;
+    return false;
+  }
+
+  std::string driver = gl_string(GL_VENDOR) + "|" + gl_string(GL_RENDERER) + "|" + gl_string(GL_VERSION);
+  driver_hash = hash_bytes(driver.data(), driver.size());
+
+  mkdir(dir.c_str(), 0755); //fails harmlessly when it exists
+
+  enabled = true;
+  return true;
+}
+
+uint64_t program_cache::key(std::initializer_list<std::string> parts) const
+{
+  uint64_t h = driver_hash;
+
+  for(const std::string& part : parts)
+  {
+    //length first so ("ab", "c") and ("a", "bc") differ
+    uint64_t size = part.size();
+    h = hash_bytes(&size, sizeof(size), h);
+    h = hash_bytes(part.data(), part.size(), h);
+  }
+
+  return h;
+}
+
+uint64_t program_cache::key(const std::string& kind, std::initializer_list<uint64_t> hashes) const
+{
+  uint64_t h = key({kind});
+
+  for(uint64_t part : hashes)
+    h = hash_bytes(&part, sizeof(part), h);
+
+  return h;
+}
+
+static std::string entry_path(const std::string& dir, uint64_t key)
+{
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+  return dir + name;
+}
+
+unsigned int program_cache::load(uint64_t key)
+{
+  if(!enabled)
+    return 0;
+
+  std::string path = entry_path(dir, key);
+  FILE* file = fopen(path.c_str(), "rb");
+
+  if(!file)
+  {
+    ++misses;
+    return 0;
+  }
+
+  cache_header header;
+  std::vector<unsigned char> binary;
+
+  bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+            header.magic == cache_magic && header.version == cache_version && header.key == key;
+
+  if(ok)
+  {
+    binary.resize(header.length);
+    ok = fread(binary.data(), 1, binary.size(), file) == binary.size();
+  }
+
+  fclose(file);
+
+  unsigned int program = 0;
+  GLint status = GL_FALSE;
+
+  if(ok)
+  {
+    program = glCreateProgram();
+    glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+  }
+
+  if(status != GL_TRUE)
+  {
+    //truncated file, or the driver no longer takes this binary
+    fprintf(stderr, "shader cache: dropping unusable entry %s\n", path.c_str());
+    if(program)
+      glDeleteProgram(program);
+    remove(path.c_str());
+    ++rejected;
+    ++misses;
+    return 0;
+  }
+
+  ++hits;
+  return program;
+}
+
+void program_cache::prepare(unsigned int program) const
+{
+  if(enabled)
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void program_cache::store(unsigned int program, uint64_t key)
+{
+  if(!enabled)
+    return;
+
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+  if(length <= 0)
+    return;
+
+  std::vector<unsigned char> binary(length);
+  GLenum format = 0;
+  glGetProgramBinary(program, length, &length, &format, binary.data());
+
+  cache_header header = {cache_magic, cache_version, key, format, (uint32_t)length};
+
+  //written next to the entry and renamed over it, so a crash or a second
+  //instance never leaves a half written binary behind
+  std::string path = entry_path(dir, key);
+  std::string temp = path + ".tmp";
+  FILE* file = fopen(temp.c_str(), "wb");
+
+  if(!file)
+  {
+    fprintf(stderr, "ERROR: failed to write shader cache entry %s\n", temp.c_str());
+    return;
+  }
+
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+            fwrite(binary.data(), 1, length, file) == (size_t)length;
+  ok = fclose(file) == 0 && ok;
+
+  if(!ok || rename(temp.c_str(), path.c_str()) != 0)
+  {
+    fprintf(stderr, "ERROR: failed to write shader cache entry %s\n", path.c_str());
+    remove(temp.c_str());
+  }
+}
+
+void program_cache::report() const
+{
+  fprintf(stderr, "shader programs: %d from cache, %d compiled (%d rejected binaries), %.2f ms\n",
+          hits, misses, rejected, build_ms);
+}
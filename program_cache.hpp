@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+// 64 bit fnv-1a, chainable through `seed`
+uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0xcbf29ce484222325ull);
+
+// linked program binaries kept on disk between launches. entries are keyed
+// by the shader sources and the driver (vendor, renderer, version), so a
+// driver update just misses. a binary the driver rejects is deleted and
+// the caller compiles from source as if nothing was cached.
+struct program_cache
+{
+  // false when the driver offers no binary formats, the cache then stays
+  // disabled and every lookup misses
+  bool init(const std::string& directory);
+
+  uint64_t key(std::initializer_list<std::string> parts) const;
+  // same, from content hashes that are already known (shader_source::hash)
+  uint64_t key(const std::string& kind, std::initializer_list<uint64_t> hashes) const;
+
+  // a linked program, or 0 on a miss
+  unsigned int load(uint64_t key);
+
+  // call before glLinkProgram on programs that will be stored
+  void prepare(unsigned int program) const;
+  void store(unsigned int program, uint64_t key);
+
+  void report() const;
+
+  std::string dir;
+  uint64_t    driver_hash = 0;
+  bool        enabled     = false;
+
+  //this launch
+  int    hits     = 0;
+  int    misses   = 0;
+  int    rejected = 0;
+  double build_ms = 0; //load, compile and link time of every program
+};
+
+extern program_cache shader_cache;
@@ -0,0 +1,139 @@
+#include "quad_batch.hpp"
+
+#include <cstdio>
+#include <vector>
+
+bool quad_index_buffer::create(int quads)
+{
+  max_quads = quads;
+  type      = quads * 4 <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+  size_t count = (size_t)quads * 6;
+
+  glCreateBuffers(1, &id);
+
+  if(type == GL_UNSIGNED_SHORT)
+  {
+    std::vector<uint16_t> data(count);
+    for(int q = 0; q < quads; ++q)
+    {
+      uint16_t v = (uint16_t)(q * 4);
+      uint16_t* i = &data[q * 6];
+      i[0] = v; i[1] = v + 1; i[2] = v + 2;
+      i[3] = v + 2; i[4] = v + 1; i[5] = v + 3;
+    }
+    glNamedBufferStorage(id, count * sizeof(uint16_t), data.data(), 0);
+  } else {
+    std::vector<uint32_t> data(count);
+    for(int q = 0; q < quads; ++q)
+    {
+      uint32_t v = (uint32_t)q * 4;
+      uint32_t* i = &data[q * 6];
+      i[0] = v; i[1] = v + 1; i[2] = v + 2;
+      i[3] = v + 2; i[4] = v + 1; i[5] = v + 3;
+    }
+    glNamedBufferStorage(id, count * sizeof(uint32_t), data.data(), 0);
+  }
+
+  return true;
+}
+
+void quad_index_buffer::destroy()
+{
+  glDeleteBuffers(1, &id);
+  id = 0;
+}
+
+bool quad_batcher::create(int max_quads_per_frame)
+{
+  //whole chunks only, so every chunk starts on a vertex boundary
+  int chunks = (max_quads_per_frame + chunk_quads - 1) / chunk_quads;
+  chunks = chunks < 1 ? 1 : chunks;
+
+  if(!vertices.create((size_t)chunks * chunk_quads * 4 * sizeof(batch_vertex)))
+    return false;
+
+  indices.create(chunk_quads);
+
+  glCreateVertexArrays(1, &vao);
+  bind_vertex_buffer<batch_vertex>(vao, 0, vertices.id, 0);
+  setup_vertex_layout<batch_vertex>(vao, 0, 0);
+  glVertexArrayElementBuffer(vao, indices.id);
+
+  return true;
+}
+
+void quad_batcher::destroy()
+{
+  glDeleteVertexArrays(1, &vao);
+  indices.destroy();
+  vertices.destroy();
+  vao = 0;
+}
+
+void quad_batcher::begin_frame()
+{
+  vertices.begin_frame();
+  chunk         = nullptr;
+  chunk_used    = 0;
+  first_pending = 0;
+  draw_calls    = 0;
+  quads         = 0;
+}
+
+void quad_batcher::end_frame()
+{
+  flush();
+  vertices.end_frame();
+}
+
+void quad_batcher::set_state(unsigned int prg, unsigned int texture0, unsigned int texture1)
+{
+  if(prg == program && texture0 == textures[0] && texture1 == textures[1])
+    return;
+
+  flush();
+
+  program     = prg;
+  textures[0] = texture0;
+  textures[1] = texture1;
+}
+
+batch_vertex* quad_batcher::add_quad()
+{
+  if(!chunk || chunk_used == chunk_quads)
+  {
+    flush();
+
+    void* ptr = nullptr;
+    size_t offset = vertices.alloc((size_t)chunk_quads * 4 * sizeof(batch_vertex), sizeof(batch_vertex), &ptr);
+
+    if(offset == (size_t)-1)
+      return nullptr;
+
+    chunk             = (batch_vertex*)ptr;
+    chunk_base_vertex = (GLint)(offset / sizeof(batch_vertex));
+    chunk_used        = 0;
+    first_pending     = 0;
+  }
+
+  ++quads;
+  return &chunk[4 * chunk_used++];
+}
+
+void quad_batcher::flush()
+{
+  int pending = chunk_used - first_pending;
+  if(pending <= 0)
+    return;
+
+  glUseProgram(program);
+  glBindTextureUnit(0, textures[0]);
+  glBindTextureUnit(1, textures[1]);
+  glBindVertexArray(vao);
+
+  glDrawElementsBaseVertex(GL_TRIANGLES, pending * 6, indices.type, nullptr, chunk_base_vertex + first_pending * 4);
+
+  first_pending = chunk_used;
+  ++draw_calls;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+
+#include "stream_buffer.hpp"
+#include "vertex_layout.hpp"
+
+// vertex for geometry that does not fit instancing (per-vertex tint, mixed
+// shapes). positions are already in world space.
+struct batch_vertex
+{
+  attrib<float, 3>                             pos;
+  attrib<uint8_t, 4, attrib_kind::NORMALIZED>  col;
+  attrib<uint16_t, 2, attrib_kind::NORMALIZED> uv;
+};
+
+VERTEX_LAYOUT(batch_vertex, pos, col, uv);
+
+// immutable index buffer describing `max_quads` quads as two triangles
+// each. corners follow the triangle strip order used everywhere else
+// (top left, top right, bottom left, bottom right). 16 bit indices while
+// they fit, 32 bit beyond that.
+struct quad_index_buffer
+{
+  bool create(int max_quads);
+  void destroy();
+
+  unsigned int id  = 0;
+  GLenum type      = GL_UNSIGNED_SHORT;
+  int max_quads    = 0;
+};
+
+// appends quads straight into a stream_buffer and draws them with the
+// shared index buffer. a draw is only issued when the program or texture
+// changes, the current chunk runs out, or flush() is called.
+struct quad_batcher
+{
+  static const int chunk_quads = 16384; //keeps indices 16 bit
+
+  bool create(int max_quads_per_frame);
+  void destroy();
+
+  void begin_frame();
+  void end_frame();
+
+  void set_state(unsigned int program, unsigned int texture0, unsigned int texture1);
+  batch_vertex* add_quad(); //returns 4 vertices to fill in
+  void flush();
+
+  stream_buffer     vertices;
+  quad_index_buffer indices;
+  unsigned int      vao = 0;
+
+  unsigned int program  = 0;
+  unsigned int textures[2] = {};
+
+  batch_vertex* chunk      = nullptr;
+  GLint  chunk_base_vertex = 0;
+  int    chunk_used        = 0;
+  int    first_pending     = 0;
+
+  //per frame counters
+  int draw_calls = 0;
+  int quads      = 0;
+};
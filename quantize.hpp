@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+// raw ieee half bits, kept as a distinct type so vertex layouts can tell it
+// apart from an unsigned short
+struct half
+{
+  uint16_t bits;
+};
+
+// float -> normalised integer conversions matching what gl does when the
+// attribute is declared with normalized = GL_TRUE
+
+constexpr int16_t snorm16(float f)
+{
+  return (int16_t)((f < -1.f ? -1.f : f > 1.f ? 1.f : f) * 32767.f + (f < 0 ? -0.5f : 0.5f));
+}
+
+constexpr uint16_t unorm16(float f)
+{
+  return (uint16_t)((f < 0.f ? 0.f : f > 1.f ? 1.f : f) * 65535.f + 0.5f);
+}
+
+constexpr uint8_t unorm8(float f)
+{
+  return (uint8_t)((f < 0.f ? 0.f : f > 1.f ? 1.f : f) * 255.f + 0.5f);
+}
+
+// ieee half, round to nearest even. to_half/from_half use the f16c
+// instruction when the target has it, the scalar versions give the same
+// bits (formats_bench --check-half compares every input)
+inline uint16_t to_half_scalar(float f)
+{
+  uint32_t x;
+  memcpy(&x, &f, 4);
+
+  uint32_t sign = (x >> 16) & 0x8000;
+  uint32_t abs  = x & 0x7fffffff;
+
+  if(abs >= 0x7f800000) //inf, or nan keeping the top of its payload, quieted
+    return (uint16_t)(sign | 0x7c00 | (abs > 0x7f800000 ? 0x200 | ((abs >> 13) & 0x3ff) : 0));
+
+  if(abs >= 0x477ff000) //overflows to inf
+    return (uint16_t)(sign | 0x7c00);
+
+  if(abs < 0x38800000) //subnormal or zero
+  {
+    if(abs < 0x33000000)
+      return (uint16_t)sign;
+
+    uint32_t mant  = (abs & 0x7fffff) | 0x800000;
+    int      shift = 126 - (int)(abs >> 23);
+    uint32_t half  = mant >> shift;
+    uint32_t rest  = mant & ((1u << shift) - 1);
+    uint32_t mid   = 1u << (shift - 1);
+    half += (rest > mid || (rest == mid && (half & 1)));
+    return (uint16_t)(sign | half);
+  }
+
+  uint32_t half = (abs - 0x38000000) >> 13;
+  uint32_t rest = abs & 0x1fff;
+  half += (rest > 0x1000 || (rest == 0x1000 && (half & 1)));
+  return (uint16_t)(sign | half);
+}
+
+inline float from_half_scalar(uint16_t h)
+{
+  uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+  uint32_t exp  = (h >> 10) & 0x1f;
+  uint32_t mant = h & 0x3ff;
+  uint32_t x;
+
+  if(exp == 0)
+  {
+    if(mant == 0)
+      x = sign;
+    else
+    {
+      //renormalise the subnormal
+      exp = 113;
+      while(!(mant & 0x400)) { mant <<= 1; --exp; }
+      x = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+    }
+  } else if(exp == 31) {
+    x = sign | 0x7f800000 | (mant << 13) | (mant ? 0x400000 : 0); //nans come out quiet
+  } else {
+    x = sign | ((exp + 112) << 23) | (mant << 13);
+  }
+
+  float f;
+  memcpy(&f, &x, 4);
+  return f;
+}
+
+inline uint16_t to_half(float f)
+{
+#if defined(__F16C__)
+  return (uint16_t)_cvtss_sh(f, 0);
+#else
+  return to_half_scalar(f);
+#endif
+}
+
+inline float from_half(uint16_t h)
+{
+#if defined(__F16C__)
+  return _cvtsh_ss(h);
+#else
+  return from_half_scalar(h);
+#endif
+}
@@ -0,0 +1,76 @@
+#include "radix_sort.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "jobs.hpp"
+
+//below this a single chunk is faster than waking workers
+static const size_t min_chunk = 16384;
+
+void radix_sort(sort_item* items, sort_item* temp, size_t count)
+{
+  if(count < 2)
+    return;
+
+  size_t chunks = std::min((size_t)jobs.thread_count() * 2, (count + min_chunk - 1) / min_chunk);
+  chunks = chunks < 1 ? 1 : chunks;
+  size_t chunk = (count + chunks - 1) / chunks;
+
+  std::vector<uint32_t> hist(chunks * 256);
+
+  sort_item* src = items;
+  sort_item* dst = temp;
+
+  for(int shift = 0; shift < 64; shift += 8)
+  {
+    std::fill(hist.begin(), hist.end(), 0);
+
+    jobs.parallel_for(chunks, 1, [&](size_t begin, size_t end) {
+      for(size_t c = begin; c < end; ++c)
+      {
+        uint32_t* h    = &hist[c * 256];
+        size_t    last = std::min(count, (c + 1) * chunk);
+        for(size_t i = c * chunk; i < last; ++i)
+          ++h[(src[i].key >> shift) & 0xff];
+      }
+    });
+
+    //turn the counts into per chunk write offsets, digit major so the
+    //result stays stable
+    size_t offset = 0;
+    bool   trivial = false;
+    for(int d = 0; d < 256; ++d)
+    {
+      size_t digit_start = offset;
+      for(size_t c = 0; c < chunks; ++c)
+      {
+        uint32_t n = hist[c * 256 + d];
+        hist[c * 256 + d] = (uint32_t)offset;
+        offset += n;
+      }
+
+      if(offset - digit_start == count)
+        trivial = true;
+    }
+
+    if(trivial)
+      continue;
+
+    jobs.parallel_for(chunks, 1, [&](size_t begin, size_t end) {
+      for(size_t c = begin; c < end; ++c)
+      {
+        uint32_t* h    = &hist[c * 256];
+        size_t    last = std::min(count, (c + 1) * chunk);
+        for(size_t i = c * chunk; i < last; ++i)
+          dst[h[(src[i].key >> shift) & 0xff]++] = src[i];
+      }
+    });
+
+    std::swap(src, dst);
+  }
+
+  if(src != items)
+    memcpy(items, src, count * sizeof(sort_item));
+}
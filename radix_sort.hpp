@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct sort_item
+{
+  uint64_t key;
+  uint32_t value;
+  uint32_t pad;
+};
+
+// stable lsd radix sort on the 64 bit key, 8 bits per pass. passes where
+// every key has the same digit are skipped, so keys that only use their
+// top bytes cost as much as their used width. histograms and scatters are
+// split across the job system. `temp` must hold `count` items; the result
+// always ends up in `items`.
+void radix_sort(sort_item* items, sort_item* temp, size_t count);
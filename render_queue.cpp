@@ -0,0 +1,198 @@
+#include "render_queue.hpp"
+
+uint64_t make_sort_key(uint8_t layer, bool translucent, unsigned int program, unsigned int texture, float depth)
+{
+  depth = depth < 0 ? 0 : depth > 1 ? 1 : depth;
+
+  uint64_t d   = (uint64_t)(depth * 0xffffff);
+  uint64_t prg = program & 0xfff;
+  uint64_t tex = texture & 0xfff;
+  uint64_t key = (uint64_t)layer << 56;
+
+  if(translucent)
+  {
+    //far things first
+    key |= 1ull << 55;
+    key |= (0xffffff - d) << 31;
+    key |= prg << 19;
+    key |= tex << 7;
+  } else {
+    key |= prg << 43;
+    key |= tex << 31;
+    key |= d << 7;
+  }
+
+  return key;
+}
+
+bool render_queue::create(int max_indirect_commands)
+{
+  return indirect.create((size_t)max_indirect_commands * sizeof(draw_elements_indirect));
+}
+
+void render_queue::destroy()
+{
+  indirect.destroy();
+}
+
+void render_queue::clear()
+{
+  commands.clear();
+  items.clear();
+}
+
+void render_queue::submit(uint64_t key, const draw_command& cmd)
+{
+  items.push_back({key, (uint32_t)commands.size(), 0});
+  commands.push_back(cmd);
+}
+
+void render_queue::sort()
+{
+  scratch.resize(items.size());
+  radix_sort(items.data(), scratch.data(), items.size());
+}
+
+static bool same_state(const draw_command& a, const draw_command& b)
+{
+  //indirect commands are already merged by whoever produced them
+  if(a.kind == draw_command::ELEMENTS_INDIRECT)
+    return false;
+
+  return a.kind == b.kind && a.mode == b.mode && a.index_type == b.index_type &&
+         a.program == b.program && a.vao == b.vao &&
+         a.textures[0] == b.textures[0] && a.textures[1] == b.textures[1];
+}
+
+static void draw_direct(const draw_command& cmd)
+{
+  if(cmd.kind == draw_command::ARRAYS_INSTANCED)
+  {
+    glDrawArraysInstancedBaseInstance(cmd.mode, cmd.first, cmd.count, cmd.instance_count, cmd.base_instance);
+  } else {
+    size_t index_size = cmd.index_type == GL_UNSIGNED_SHORT ? 2 : 4;
+    glDrawElementsInstancedBaseVertexBaseInstance(cmd.mode, cmd.count, cmd.index_type,
+                                                  (const void*)(cmd.first * index_size),
+                                                  cmd.instance_count, cmd.base_vertex, cmd.base_instance);
+  }
+}
+
+void render_queue::execute(gl_stats& stats)
+{
+  unsigned int program = ~0u;
+  unsigned int vao     = ~0u;
+  unsigned int textures[2] = {~0u, ~0u};
+  unsigned int indirect_bound = 0;
+
+  if(indirect.id)
+    indirect.begin_frame();
+
+  size_t i = 0;
+  while(i < items.size())
+  {
+    const draw_command& cmd = commands[items[i].value];
+
+    //the run of sorted commands that can share one call
+    size_t end = i + 1;
+    while(end < items.size() && same_state(cmd, commands[items[end].value]))
+      ++end;
+
+    if(cmd.program != program)
+    {
+      glUseProgram(cmd.program);
+      program = cmd.program;
+      ++stats.program_binds;
+    }
+
+    if(cmd.vao != vao)
+    {
+      glBindVertexArray(cmd.vao);
+      vao = cmd.vao;
+      ++stats.vao_binds;
+    }
+
+    for(int unit = 0; unit < 2; ++unit)
+    {
+      if(cmd.textures[unit] != textures[unit])
+      {
+        glBindTextureUnit(unit, cmd.textures[unit]);
+        textures[unit] = cmd.textures[unit];
+        ++stats.texture_binds;
+      }
+    }
+
+    size_t run = end - i;
+    bool elements = cmd.kind == draw_command::ELEMENTS_INSTANCED;
+    size_t stride = elements ? sizeof(draw_elements_indirect) : sizeof(draw_arrays_indirect);
+
+    if(cmd.kind == draw_command::ELEMENTS_INDIRECT)
+    {
+      if(indirect_bound != cmd.indirect_buffer)
+      {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, cmd.indirect_buffer);
+        indirect_bound = cmd.indirect_buffer;
+      }
+
+      glMultiDrawElementsIndirect(cmd.mode, cmd.index_type, (const void*)cmd.indirect_offset, cmd.draw_count, 0);
+
+      ++stats.draw_calls;
+      ++stats.multi_draws;
+      i = end;
+      continue;
+    }
+
+    void* ptr = nullptr;
+    bool merge = multi_draw && indirect.id && run > 1 &&
+                 (indirect.head + 3) / 4 * 4 + run * stride <= indirect.region_size;
+
+    if(merge)
+    {
+      size_t offset = indirect.alloc(run * stride, 4, &ptr);
+
+      if(indirect_bound != indirect.id)
+      {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect.id);
+        indirect_bound = indirect.id;
+      }
+
+      if(elements)
+      {
+        draw_elements_indirect* out = (draw_elements_indirect*)ptr;
+        for(size_t k = 0; k < run; ++k)
+        {
+          const draw_command& c = commands[items[i + k].value];
+          out[k] = {(GLuint)c.count, (GLuint)c.instance_count, (GLuint)c.first, c.base_vertex, c.base_instance};
+        }
+        glMultiDrawElementsIndirect(cmd.mode, cmd.index_type, (const void*)offset, (GLsizei)run, 0);
+      } else {
+        draw_arrays_indirect* out = (draw_arrays_indirect*)ptr;
+        for(size_t k = 0; k < run; ++k)
+        {
+          const draw_command& c = commands[items[i + k].value];
+          out[k] = {(GLuint)c.count, (GLuint)c.instance_count, (GLuint)c.first, c.base_instance};
+        }
+        glMultiDrawArraysIndirect(cmd.mode, (const void*)offset, (GLsizei)run, 0);
+      }
+
+      ++stats.draw_calls;
+      ++stats.multi_draws;
+    } else {
+      //single commands, or the indirect region for this frame is full
+      for(size_t k = i; k < end; ++k)
+      {
+        draw_direct(commands[items[k].value]);
+        ++stats.draw_calls;
+      }
+    }
+
+    i = end;
+  }
+
+  stats.commands += (int)items.size();
+}
+
+void render_queue::end_frame()
+{
+  if(indirect.id)
+    indirect.end_frame();
+}
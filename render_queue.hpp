@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glad/gl.h>
+
+#include "radix_sort.hpp"
+#include "stream_buffer.hpp"
+
+// sort key, most significant first:
+//
+//   opaque       layer:8 | 0 | program:12 | texture:12 | depth:24 (front to back) | 0:7
+//   translucent  layer:8 | 1 | depth:24 (back to front) | program:12 | texture:12 | 0:7
+//
+// opaque draws group by state, translucent ones keep painter's order and
+// only group state among draws at the same depth.
+uint64_t make_sort_key(uint8_t layer, bool translucent, unsigned int program, unsigned int texture, float depth);
+
+struct draw_command
+{
+  enum kind_t : uint8_t
+  {
+    ARRAYS_INSTANCED,
+    ELEMENTS_INSTANCED,
+    ELEMENTS_INDIRECT,  //parameters already live in a gpu buffer
+  };
+
+  kind_t       kind;
+  GLenum       mode;
+  GLenum       index_type;
+  unsigned int program;
+  unsigned int vao;
+  unsigned int textures[2];
+  int          first;          //first vertex, or first index for elements
+  int          count;
+  int          instance_count;
+  unsigned int base_instance;
+  int          base_vertex;
+
+  //ELEMENTS_INDIRECT only: draw_count commands at indirect_offset
+  unsigned int indirect_buffer;
+  size_t       indirect_offset;
+  int          draw_count;
+};
+
+// layouts glMultiDraw*Indirect reads from the indirect buffer
+struct draw_elements_indirect
+{
+  GLuint count;
+  GLuint instance_count;
+  GLuint first_index;
+  GLint  base_vertex;
+  GLuint base_instance;
+};
+
+struct draw_arrays_indirect
+{
+  GLuint count;
+  GLuint instance_count;
+  GLuint first;
+  GLuint base_instance;
+};
+
+// gl work done by execute(), reported with --stats. commands is what was
+// submitted, draw_calls what reached the driver after merging.
+struct gl_stats
+{
+  int draw_calls    = 0;
+  int multi_draws   = 0;
+  int program_binds = 0;
+  int vao_binds     = 0;
+  int texture_binds = 0;
+  int commands      = 0;
+
+  void reset() { *this = gl_stats(); }
+};
+
+// draws are recorded as (key, command) pairs instead of being issued
+// directly, then sorted once and replayed with redundant binds dropped.
+// runs of sorted commands sharing all state become one multi draw whose
+// parameters are written into a persistently mapped indirect buffer.
+struct render_queue
+{
+  bool create(int max_indirect_commands);
+  void destroy();
+
+  void clear();
+  void submit(uint64_t key, const draw_command& cmd);
+  void sort();
+  void execute(gl_stats& stats);
+  void end_frame();
+
+  std::vector<draw_command> commands;
+  std::vector<sort_item>    items;
+  std::vector<sort_item>    scratch;
+
+  stream_buffer indirect;
+  bool          multi_draw = true;
+};
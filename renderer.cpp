@@ -0,0 +1,404 @@
+#include "renderer.hpp"
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+#include <glad/gl.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "frustum.hpp"
+#include "jobs.hpp"
+#include "program_cache.hpp"
+#include "quantize.hpp"
+#include "render_queue.hpp"
+#include "shader.hpp"
+
+#define error(X) fprintf(stderr, "ERROR: %s\n", X)
+
+#define V(x, y, z, r, g, b, a, u, v) \
+  { {snorm16(x), snorm16(y), snorm16(z)}, 0, {unorm8(r), unorm8(g), unorm8(b), unorm8(a)}, {unorm16(u), unorm16(v)} }
+
+vertex points[] =
+{
+  V(-0.5, 0.5, 0.0,   1.0, 0.0, 0.0, 1.0,   0.0, 0.0),
+  V( 0.5, 0.5, 0.0,   1.0, 0.0, 0.0, 1.0,   0.5, 0.0),
+  V(-0.5,-0.5, 0.0,   0.0, 1.0, 0.0, 1.0,   0.0, 1.0),
+  V( 0.5,-0.5, 0.0,   0.0, 0.0, 1.0, 1.0,   0.5, 1.0),
+};
+
+#undef V
+
+bool renderer::init()
+{
+  shader_cache.init("./shader_cache");
+  shaders.init(glfwGetProcAddress);
+
+  //issued first so the driver compiles while buffers and textures load
+  sprite_shaders.create(shaders, "./shaders/shader.vert", "./shaders/shader.frag", {"COLOR_EFFECT"});
+  sprite_shaders.get(0);
+  cull_program   = shaders.submit_compute("./shaders/cull.comp");
+
+  //edits to the sources are rebuilt and swapped in while running
+  shaders.watch("./shaders");
+
+  //decoded on the workers and streamed in by draw(), nothing waits here
+  if(!assets.create())
+  {
+    error("failed to create the asset loader");
+    return false;
+  }
+
+  bird_texture       = assets.load_texture("./bird64.png");
+  background_texture = assets.load_texture("./background.png");
+
+  if(!uniforms.create())
+  {
+    error("failed to create uniform buffers");
+    return false;
+  }
+
+  if(!queue.create(4096))
+  {
+    error("failed to create indirect draw buffer");
+    return false;
+  }
+
+  glCreateBuffers(1, &buffer);
+  glNamedBufferData(buffer, sizeof(vertex) * 4, points, GL_STATIC_DRAW);
+  //glNamedBufferStorage(vbo, sizeof(vertex)*vertex_count, vertices, GL_DYNAMIC_STORAGE_BIT);
+
+  //sprites are indexed so they merge with other element batches
+  quad_indices.create(1);
+
+  glCreateVertexArrays(1, &vao);
+
+  bind_vertex_buffer<vertex>(vao, 0, buffer, 0);
+  glVertexArrayElementBuffer(vao, quad_indices.id);
+  setup_vertex_layout<vertex>(vao, 0, 0);
+
+  //binding 1 advances once per sprite, its buffer is attached every frame
+  setup_vertex_layout<sprite_instance>(vao, 1, vertex_layout<vertex>::count, 1);
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  return true;
+}
+
+void renderer::draw(const frame_snapshot& snap, float alpha)
+{
+  sim_state state = sim_interpolate(snap.prev, snap.curr, alpha);
+
+  cam.set_zoom(state.cam_z);
+  cam.set_rotation(state.cam_x, state.cam_y);
+
+  if(!shaders.poll() && !shaders_reported)
+  {
+    shader_cache.report();
+    shaders_reported = true;
+  }
+
+  //sprites show up once their program is linked. gpu culling waits for
+  //its program too, the cpu path covers the frames before. both are read
+  //every frame so a hot reloaded program is picked up on the next one
+  //a newly requested variant falls back to the plain one while it builds
+  prg = sprite_shaders.program(sprite_features);
+
+  if(cull.program)
+    cull.program = shaders.program(cull_program);
+
+  assets.update();
+  texture    = assets.texture(bird_texture);
+  background = assets.texture(background_texture);
+
+  unsigned int sampler = samplers.get(sprite_sampling);
+  if(sampler != bound_sampler)
+  {
+    unsigned int units[2] = {sampler, sampler};
+    glBindSamplers(0, 2, units);
+    bound_sampler = sampler;
+  }
+
+  if(gpu_culling && !cull.program)
+  {
+    if(shaders.status(cull_program) == shader_manager::FAILED)
+      gpu_culling = false;
+    else if(shaders.status(cull_program) == shader_manager::READY && !cull.create(shaders.program(cull_program)))
+      gpu_culling = false;
+  }
+
+  size_t count = 0;
+  const uint32_t* indices = cull_sprites(snap, count);
+  upload_instances(snap.instances, indices, count);
+  submitted_sprites += count;
+
+  if(recording)
+  {
+    size_t stride = (size_t)window_width * 4;
+    capture.resize(stride * window_height);
+    capture_flipped.resize(stride * window_height);
+
+    glReadPixels(0, 0, window_width, window_height, GL_RGBA, GL_UNSIGNED_BYTE, capture.data()); //nice trick
+
+    //gl rows are bottom-up, flip them in parallel while copying out
+    int h = window_height;
+    jobs.parallel_for(h, 64, [&](size_t begin, size_t end) {
+      for(size_t y = begin; y < end; ++y)
+        memcpy(&capture_flipped[y * stride], &capture[(h - 1 - y) * stride], stride);
+    });
+
+    std::cout.write((const char*)capture_flipped.data(), capture_flipped.size());
+    //Image_save(img, "screenshot.png");
+  }
+
+  frame_uniforms frame_data;
+  frame_data.resolution = glm::vec2(window_width, window_height);
+  frame_data.time       = state.time;
+  frame_data.dt         = last_draw > 0 ? state.time - last_draw : 0;
+  uniforms.upload_frame(frame_data);
+  last_draw = state.time;
+
+  //matrices are only rebuilt and uploaded when input touched the camera
+  cam.set_viewport({0, 0, window_width, window_height});
+  uniforms.sync_view(0, cam);
+  uniforms.bind_view(0);
+
+  glClearColor(0.2, 0.2, 0.2, 1.f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+  queue.clear();
+
+  //nothing to draw sprites with while their program is still compiling
+  //or their textures are still streaming in
+  bool sprites_ready = prg && texture && background;
+
+  if(sprites_ready && gpu_culling && cull.program)
+    submit_culled_sprites();
+  else if(sprites_ready)
+    submit_sprites();
+
+  queue.sort();
+  queue.execute(stats);
+
+  queue.end_frame();
+  uniforms.end_frame();
+  instance_buffer.end_frame();
+
+  report_stats();
+}
+
+// window space depth of the sprite plane (z = 0) in [0, 1]. every sprite
+// lies in that plane, so all sprite batches share it and their layer is
+// what orders them; the depth matters once translucent geometry is
+// submitted at other distances
+static float sprite_depth(camera& cam)
+{
+  glm::vec4 p = cam.mvp() * glm::vec4(0.f, 0.f, 0.f, 1.f);
+  return p.w > 0.f ? p.z / p.w * 0.5f + 0.5f : 0.f;
+}
+
+// one command per non-empty sprite layer, the queue puts them in
+// back-to-front order for blending, drops redundant binds and merges
+// the layers into a single multi draw
+void renderer::submit_sprites()
+{
+  float depth = sprite_depth(cam);
+
+  for(int layer = 0; layer < 256; ++layer)
+  {
+    if(!layer_counts[layer])
+      continue;
+
+    draw_command cmd = {};
+    cmd.kind           = draw_command::ELEMENTS_INSTANCED;
+    cmd.mode           = GL_TRIANGLES;
+    cmd.index_type     = quad_indices.type;
+    cmd.program        = prg;
+    cmd.vao            = vao;
+    cmd.textures[0]    = texture;
+    cmd.textures[1]    = background;
+    cmd.first          = 0;
+    cmd.count          = 6;
+    cmd.instance_count = layer_counts[layer];
+    cmd.base_instance  = layer_starts[layer];
+
+    queue.submit(make_sort_key(layer, true, prg, texture, depth), cmd);
+  }
+}
+
+// the cull pass writes one indirect command per layer. a single multi draw
+// over the used layer span keeps them in back-to-front order, empty layers
+// in between have zero instances.
+void renderer::submit_culled_sprites()
+{
+  cull.run(instance_buffer.id, instance_first, instance_count, layer_counts, layer_starts, 6);
+  bind_vertex_buffer<sprite_instance>(vao, 1, cull.visible, 0);
+
+  int first_layer = -1, last_layer = -1;
+  for(int layer = 0; layer < 256; ++layer)
+  {
+    if(!layer_counts[layer])
+      continue;
+
+    first_layer = first_layer < 0 ? layer : first_layer;
+    last_layer  = layer;
+  }
+
+  if(first_layer < 0)
+    return;
+
+  draw_command cmd = {};
+  cmd.kind            = draw_command::ELEMENTS_INDIRECT;
+  cmd.mode            = GL_TRIANGLES;
+  cmd.index_type      = quad_indices.type;
+  cmd.program         = prg;
+  cmd.vao             = vao;
+  cmd.textures[0]     = texture;
+  cmd.textures[1]     = background;
+  cmd.indirect_buffer = cull.commands;
+  cmd.indirect_offset = first_layer * sizeof(draw_elements_indirect);
+  cmd.draw_count      = last_layer - first_layer + 1;
+
+  queue.submit(make_sort_key(first_layer, true, prg, texture, sprite_depth(cam)), cmd);
+}
+
+// indices of the sprites whose bounds touch the view frustum. null (draw
+// everything) when culling is off, left to the gpu, or bounds are missing.
+const uint32_t* renderer::cull_sprites(const frame_snapshot& snap, size_t& count)
+{
+  const sprite_bounds& b = snap.bounds;
+  count = snap.instances.size();
+
+  if(!cpu_culling || (gpu_culling && cull.program) || b.center_x.size() != count)
+    return nullptr;
+
+  //the vertex shader divides x by the aspect after scaling, fold that in
+  //so the planes apply to the unscaled bounds
+  glm::mat4 aspect(1.0f);
+  aspect[0][0] = window_height / (float)window_width;
+
+  frustum f = extract_frustum(cam.mvp() * aspect);
+
+  aabb_soa boxes;
+  boxes.center_x = b.center_x.data();
+  boxes.center_y = b.center_y.data();
+  boxes.extent_x = b.extent_x.data();
+  boxes.extent_y = b.extent_y.data();
+  boxes.count    = b.center_x.size();
+
+  visible.resize(boxes.count);
+  count = cull_aabbs(f, boxes, visible.data());
+  return visible.data();
+}
+
+void renderer::report_stats()
+{
+  ++stats_frames;
+
+  double now = glfwGetTime();
+  if(!print_stats || now - last_stats < 1.0)
+    return;
+
+  //the compute pass decides visibility on the gpu, nothing reads its count
+  //back, so under --gpu-cull this is every sprite rather than the drawn ones
+  fprintf(stderr, "sprites per frame: %.1f submitted%s\n", submitted_sprites / (double)stats_frames,
+          gpu_culling && cull.program ? " (culled on the gpu)" : "");
+  fprintf(stderr, "gl per frame: %.1f commands, %.1f draws (%.1f multi), %.1f program binds, %.1f vao binds, %.1f texture binds\n",
+          stats.commands / (double)stats_frames, stats.draw_calls / (double)stats_frames,
+          stats.multi_draws / (double)stats_frames,
+          stats.program_binds / (double)stats_frames, stats.vao_binds / (double)stats_frames,
+          stats.texture_binds / (double)stats_frames);
+
+  stats.reset();
+  submitted_sprites = 0;
+  stats_frames  = 0;
+  last_stats   = now;
+}
+
+// copies `count` instances, instances[visible[i]] or the first `count`
+// when visible is null
+void renderer::upload_instances(const std::vector<sprite_instance>& instances, const uint32_t* visible, size_t count)
+{
+  size_t bytes = count * sizeof(sprite_instance);
+
+  if(count > instance_capacity)
+  {
+    //grow geometrically, the old buffer stays alive in the driver until
+    //the frames reading it are done
+    instance_capacity = instance_capacity ? instance_capacity : 1024;
+    while(instance_capacity < count)
+      instance_capacity *= 2;
+
+    instance_buffer.destroy();
+    instance_buffer.create(instance_capacity * sizeof(sprite_instance));
+  }
+
+  instance_buffer.begin_frame();
+
+  void* ptr = nullptr;
+  size_t offset = instance_buffer.alloc(bytes ? bytes : sizeof(sprite_instance), sizeof(sprite_instance), &ptr);
+
+  //counting sort by layer while copying, so each layer is one contiguous
+  //instance range. the common unculled single layer case stays a plain memcpy.
+  memset(layer_counts, 0, sizeof(layer_counts));
+  if(visible)
+  {
+    for(size_t i = 0; i < count; ++i)
+      ++layer_counts[instances[visible[i]].layer];
+  } else {
+    for(size_t i = 0; i < count; ++i)
+      ++layer_counts[instances[i].layer];
+  }
+
+  int layers = 0;
+  unsigned int start = 0;
+  for(int layer = 0; layer < 256; ++layer)
+  {
+    layer_starts[layer] = start;
+    start += layer_counts[layer];
+    layers += layer_counts[layer] > 0;
+  }
+
+  sprite_instance* out = (sprite_instance*)ptr;
+
+  if(layers <= 1 && !visible)
+  {
+    if(bytes)
+      memcpy(ptr, instances.data(), bytes);
+  } else if(layers <= 1) {
+    for(size_t i = 0; i < count; ++i)
+      out[i] = instances[visible[i]];
+  } else {
+    unsigned int cursor[256];
+    memcpy(cursor, layer_starts, sizeof(cursor));
+
+    for(size_t i = 0; i < count; ++i)
+    {
+      const sprite_instance& inst = instances[visible ? visible[i] : i];
+      out[cursor[inst.layer]++] = inst;
+    }
+  }
+
+  instance_first = offset / sizeof(sprite_instance);
+  instance_count = count;
+
+  bind_vertex_buffer<sprite_instance>(vao, 1, instance_buffer.id, offset);
+}
+
+void renderer::shutdown()
+{
+  queue.destroy();
+  cull.destroy();
+  shaders.shutdown();
+  quad_indices.destroy();
+  glDeleteVertexArrays(1, &vao);
+  uniforms.destroy();
+  instance_buffer.destroy();
+  assets.destroy();
+  samplers.destroy();
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "asset_loader.hpp"
+#include "camera.hpp"
+#include "frame.hpp"
+#include "gpu_cull.hpp"
+#include "quad_batch.hpp"
+#include "render_queue.hpp"
+#include "samplers.hpp"
+#include "shader_manager.hpp"
+#include "uniforms.hpp"
+#include "vertex_layout.hpp"
+
+extern int window_width;
+extern int window_height;
+
+// 16 bytes: snorm16 position, unorm8 colour, unorm16 uv
+struct vertex
+{
+  attrib<int16_t, 3, attrib_kind::NORMALIZED>  pos;
+  int16_t                                      pad;
+  attrib<uint8_t, 4, attrib_kind::NORMALIZED>  col;
+  attrib<uint16_t, 2, attrib_kind::NORMALIZED> uv;
+};
+
+VERTEX_LAYOUT(vertex, pos, col, uv);
+
+static_assert(sizeof(vertex) == 16, "vertex must stay 16 bytes");
+
+// bits of renderer::sprite_features, in the order given to sprite_shaders
+enum sprite_feature : uint32_t
+{
+  SPRITE_COLOR_EFFECT = 1 << 0,
+};
+
+// owns every gl object of the scene. all calls must come from the thread
+// the context is current on.
+struct renderer
+{
+  bool init();
+  void draw(const frame_snapshot& snap, float alpha);
+  void shutdown();
+
+  const uint32_t* cull_sprites(const frame_snapshot& snap, size_t& count);
+  void upload_instances(const std::vector<sprite_instance>& instances, const uint32_t* visible, size_t count);
+  void submit_sprites();
+  void submit_culled_sprites();
+  void report_stats();
+
+  unsigned int prg        = 0;
+  unsigned int buffer     = 0;
+  unsigned int vao        = 0;
+  unsigned int texture    = 0;
+  unsigned int background = 0;
+
+  quad_index_buffer quad_indices;
+
+  asset_loader assets;
+  int          bird_texture       = -1;
+  int          background_texture = -1;
+
+  //both sprite units share one sampler, chosen with --filter
+  sampler_cache samplers;
+  sampler_desc  sprite_sampling;
+  unsigned int  bound_sampler = 0;
+
+  camera         cam;
+  uniform_system uniforms;
+
+  //per-instance sprite records, streamed every frame
+  stream_buffer  instance_buffer;
+  size_t         instance_capacity = 0;
+  unsigned int   layer_counts[256];
+  unsigned int   layer_starts[256];
+  unsigned int   instance_first = 0;
+  unsigned int   instance_count = 0;
+
+  //visible sprite indices from the cpu frustum test
+  std::vector<uint32_t> visible;
+  bool           cpu_culling = true;
+  size_t         submitted_sprites = 0; //uploaded, before any gpu culling
+
+  //--gpu-cull: visibility is decided by a compute pass instead
+  gpu_cull       cull;
+  bool           gpu_culling = false;
+
+  //programs compile in the background, see draw()
+  shader_manager shaders;
+  shader_variants sprite_shaders;
+  uint32_t       sprite_features = 0;
+  int            cull_program   = -1;
+  bool           shaders_reported = false;
+
+  render_queue   queue;
+  gl_stats       stats;
+  bool           print_stats  = false;
+  int            stats_frames = 0;
+  double         last_stats   = 0;
+
+  bool   recording      = false;
+  std::vector<unsigned char> capture;
+  std::vector<unsigned char> capture_flipped;
+  double last_draw      = 0;
+};
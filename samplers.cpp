@@ -0,0 +1,66 @@
+#include "samplers.hpp"
+
+#include <cstring>
+
+#include "shader.hpp"
+
+//ARB/EXT_texture_filter_anisotropic, core only from 4.6
+#ifndef GL_TEXTURE_MAX_ANISOTROPY
+#define GL_TEXTURE_MAX_ANISOTROPY 0x84FE
+#endif
+#ifndef GL_MAX_TEXTURE_MAX_ANISOTROPY
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY 0x84FF
+#endif
+
+bool parse_sampler_preset(const char* name, sampler_desc& desc)
+{
+  desc = sampler_desc();
+
+  if(strcmp(name, "nearest") == 0)
+  {
+    desc.min_filter = GL_NEAREST;
+    desc.mag_filter = GL_NEAREST;
+  } else if(strcmp(name, "pixel") == 0) {
+    desc.mag_filter = GL_NEAREST;
+  } else if(strcmp(name, "trilinear") != 0) {
+    return false;
+  }
+
+  return true;
+}
+
+unsigned int sampler_cache::get(const sampler_desc& desc)
+{
+  for(const auto& s : samplers)
+    if(s.first == desc)
+      return s.second;
+
+  if(max_anisotropy < 0)
+  {
+    max_anisotropy = 1;
+    if(has_gl_extension("GL_ARB_texture_filter_anisotropic") || has_gl_extension("GL_EXT_texture_filter_anisotropic"))
+      glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &max_anisotropy);
+  }
+
+  unsigned int id = 0;
+  glCreateSamplers(1, &id);
+  glSamplerParameteri(id, GL_TEXTURE_MIN_FILTER, desc.min_filter);
+  glSamplerParameteri(id, GL_TEXTURE_MAG_FILTER, desc.mag_filter);
+  glSamplerParameteri(id, GL_TEXTURE_WRAP_S, desc.wrap);
+  glSamplerParameteri(id, GL_TEXTURE_WRAP_T, desc.wrap);
+  glSamplerParameterf(id, GL_TEXTURE_LOD_BIAS, desc.lod_bias);
+
+  if(max_anisotropy > 1 && desc.max_anisotropy > 1)
+    glSamplerParameterf(id, GL_TEXTURE_MAX_ANISOTROPY, desc.max_anisotropy < max_anisotropy ? desc.max_anisotropy : max_anisotropy);
+
+  samplers.push_back({desc, id});
+  return id;
+}
+
+void sampler_cache::destroy()
+{
+  for(const auto& s : samplers)
+    glDeleteSamplers(1, &s.second);
+
+  samplers.clear();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+#include <glad/gl.h>
+
+struct sampler_desc
+{
+  GLenum min_filter     = GL_LINEAR_MIPMAP_LINEAR;
+  GLenum mag_filter     = GL_LINEAR;
+  GLenum wrap           = GL_REPEAT;
+  float  max_anisotropy = 1.f;
+  float  lod_bias       = 0.f;
+
+  bool operator==(const sampler_desc& o) const
+  {
+    return min_filter == o.min_filter && mag_filter == o.mag_filter && wrap == o.wrap
+        && max_anisotropy == o.max_anisotropy && lod_bias == o.lod_bias;
+  }
+};
+
+// "nearest" (no mips, the old look), "pixel" (trilinear minification,
+// crisp magnification) or "trilinear". false for anything else
+bool parse_sampler_preset(const char* name, sampler_desc& desc);
+
+// gl sampler objects, one per distinct description, shared by every
+// texture sampled that way. a sampler bound to a unit overrides the
+// filtering and wrapping stored in the texture itself.
+struct sampler_cache
+{
+  unsigned int get(const sampler_desc& desc);
+  void destroy();
+
+  std::vector<std::pair<sampler_desc, unsigned int>> samplers;
+  float max_anisotropy = -1; //queried on first use, 1 without the extension
+};
@@ -0,0 +1,57 @@
+#include "shader.hpp"
+
+#include <glad/gl.h>
+
+#include <cstdio>
+#include <cstring>
+
+char elog[2048];
+
+bool has_gl_extension(const char* name)
+{
+  GLint count = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+  for(GLint i = 0; i < count; ++i)
+  {
+    const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, i);
+    if(ext && strcmp(ext, name) == 0)
+      return true;
+  }
+
+  return false;
+}
+
+void check_shader_compilation(unsigned int id)
+{
+  int status = -1;
+  glGetShaderiv(id, GL_COMPILE_STATUS, &status);
+
+  if(status == GL_FALSE)
+  {
+     //long logs are cut to the buffer, broken saves are routine with reload
+     int logsize = 0;
+     glGetShaderInfoLog(id, sizeof(elog), &logsize, elog);
+     fprintf(stderr, "SHADER ERROR: %s\n", elog);
+  }
+}
+
+bool check_shader_program_linkage(unsigned int id) {
+
+  int lparams = -1;
+  glGetProgramiv(id, GL_LINK_STATUS, &lparams);
+
+  if(GL_TRUE == lparams)
+    return true;
+
+  fprintf(stderr, "failed to link shader program with GL index %u\n", id);
+
+  const int max_length = 2048;
+  int actual_length    = 0;
+
+  glGetProgramInfoLog(id, max_length, &actual_length, elog);
+  fprintf(stderr, "program info log for program with GL index %u\n\t%s", id, elog);
+
+  glDeleteProgram(id);
+  return false;
+}
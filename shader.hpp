@@ -0,0 +1,9 @@
+#pragma once
+
+extern char elog[2048];
+
+// looks through GL_EXTENSIONS of the current context
+bool has_gl_extension(const char* name);
+
+bool check_shader_program_linkage(unsigned int id);
+void check_shader_compilation(unsigned int id);
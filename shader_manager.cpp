@@ -0,0 +1,411 @@
+#include "shader_manager.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "program_cache.hpp"
+#include "shader.hpp"
+#include "source_files.hpp"
+
+//KHR_parallel_shader_compile, same values as the ARB version
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+typedef void (GLAD_API_PTR *max_compiler_threads_fn)(GLuint count);
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// #version has to stay the first line, the defines go right after it.
+// a #line after them puts the numbering back, so compiler errors in the
+// root file (source 0) still point at the right line
+static void inject_defines(std::string& src, const std::string& defines)
+{
+  if(defines.empty())
+    return;
+
+  size_t version = src.find("#version");
+  size_t eol     = version == std::string::npos ? std::string::npos : src.find('\n', version);
+
+  if(eol == std::string::npos)
+  {
+    src.insert(0, defines + "#line 1 0\n");
+    return;
+  }
+
+  size_t next_line = std::count(src.begin(), src.begin() + eol, '\n') + 2;
+  src.insert(eol + 1, defines + "#line " + std::to_string(next_line) + " 0\n");
+}
+
+void shader_manager::init(GLADloadfunc load)
+{
+  //glad here is core only, the extension entry point is fetched by hand
+  max_compiler_threads_fn max_threads = nullptr;
+
+  if(has_gl_extension("GL_KHR_parallel_shader_compile"))
+    max_threads = (max_compiler_threads_fn)load("glMaxShaderCompilerThreadsKHR");
+  else if(has_gl_extension("GL_ARB_parallel_shader_compile"))
+    max_threads = (max_compiler_threads_fn)load("glMaxShaderCompilerThreadsARB");
+
+  parallel = max_threads != nullptr;
+
+  //let the driver pick the thread count
+  if(max_threads)
+    max_threads(0xFFFFFFFF);
+
+  fprintf(stderr, "shaders: parallel compile %s\n", parallel ? "available" : "not available, compiles finish in order");
+}
+
+void shader_manager::shutdown()
+{
+  for(entry& e : programs)
+  {
+    discard(e);
+    if(e.program)
+      glDeleteProgram(e.program);
+  }
+
+  programs.clear();
+
+#if defined(__linux__)
+  if(watch_fd >= 0)
+    close(watch_fd);
+#endif
+  watch_fd = -1;
+}
+
+// drops the in flight build, if any
+void shader_manager::discard(entry& e)
+{
+  for(unsigned int& s : e.shaders)
+  {
+    if(s)
+      glDeleteShader(s);
+    s = 0;
+  }
+
+  if(e.build)
+    glDeleteProgram(e.build);
+  e.build = 0;
+}
+
+// (re)reads the sources and issues the build. a cache hit replaces the
+// live program right away.
+void shader_manager::start(entry& e)
+{
+  auto start = std::chrono::steady_clock::now();
+
+  discard(e);
+
+  //library results are references into a map, loading the second
+  //stage leaves the first one valid
+  const shader_source* loaded[2] = {};
+  for(int i = 0; i < e.stages; ++i)
+  {
+    loaded[i] = shader_library.load(e.files[i]);
+
+    if(!loaded[i])
+    {
+      //still watch the root, so fixing it retries the build
+      if(e.deps.empty())
+        e.deps.assign(e.files, e.files + e.stages);
+
+      fprintf(stderr, "ERROR: failed to build %s\n", e.name.c_str());
+      e.status = e.program ? READY : FAILED;
+      return;
+    }
+  }
+
+  e.deps.clear();
+  for(int i = 0; i < e.stages; ++i)
+    e.deps.insert(e.deps.end(), loaded[i]->files.begin(), loaded[i]->files.end());
+
+  //the defines are part of the kind, so a plain variant keeps the key it
+  //had before variants existed
+  std::string kind = e.defines.empty() ? e.kind : std::string(e.kind) + "\n" + e.defines;
+
+  switch(e.stages)
+  {
+    case 1: e.key = shader_cache.key(kind, {loaded[0]->hash}); break;
+    default: e.key = shader_cache.key(kind, {loaded[0]->hash, loaded[1]->hash}); break;
+  }
+
+  if(unsigned int cached = shader_cache.load(e.key))
+  {
+    if(e.program)
+      glDeleteProgram(e.program);
+    e.program = cached;
+    e.status  = READY;
+    shader_cache.build_ms += elapsed_ms(start);
+    return;
+  }
+
+  //queue everything, no status query until the driver says it is done
+  e.build = glCreateProgram();
+
+  for(int i = 0; i < e.stages; ++i)
+  {
+    std::string source = loaded[i]->text;
+    inject_defines(source, e.defines);
+
+    const char* src = source.data();
+    e.shaders[i] = glCreateShader(e.types[i]);
+    glShaderSource(e.shaders[i], 1, &src, NULL);
+    glCompileShader(e.shaders[i]);
+    glAttachShader(e.build, e.shaders[i]);
+  }
+
+  shader_cache.prepare(e.build);
+  glLinkProgram(e.build);
+
+  e.status = e.program ? READY : PENDING;
+  shader_cache.build_ms += elapsed_ms(start); //issue time only
+}
+
+int shader_manager::submit(const std::string& vshader_file, const std::string& fshader_file, const std::string& defines)
+{
+  entry e;
+  e.name     = vshader_file + "+" + fshader_file;
+  e.defines  = defines;
+  e.kind     = "vert+frag";
+  e.files[0] = vshader_file;
+  e.files[1] = fshader_file;
+  e.types[0] = GL_VERTEX_SHADER;
+  e.types[1] = GL_FRAGMENT_SHADER;
+  e.stages   = 2;
+
+  programs.push_back(e);
+  start(programs.back());
+  return (int)programs.size() - 1;
+}
+
+int shader_manager::submit_compute(const std::string& cshader_file, const std::string& defines)
+{
+  entry e;
+  e.name     = cshader_file;
+  e.defines  = defines;
+  e.kind     = "comp";
+  e.files[0] = cshader_file;
+  e.types[0] = GL_COMPUTE_SHADER;
+  e.stages   = 1;
+
+  programs.push_back(e);
+  start(programs.back());
+  return (int)programs.size() - 1;
+}
+
+// link status and logs, only queried once the work is known to be done
+// (or when the caller accepts blocking). a program that links replaces
+// the live one, a failed reload leaves it alone.
+void shader_manager::finish(entry& e)
+{
+  auto start = std::chrono::steady_clock::now();
+
+  for(unsigned int& s : e.shaders)
+  {
+    if(!s)
+      continue;
+
+    check_shader_compilation(s);
+    glDetachShader(e.build, s);
+    glDeleteShader(s);
+    s = 0;
+  }
+
+  bool reload = e.program != 0;
+
+  if(check_shader_program_linkage(e.build))
+  {
+    shader_cache.store(e.build, e.key);
+    if(e.program)
+      glDeleteProgram(e.program);
+    e.program = e.build;
+    e.status  = READY;
+    if(reload)
+      fprintf(stderr, "shaders: reloaded %s\n", e.name.c_str());
+  } else if(reload) {
+    fprintf(stderr, "ERROR: failed to rebuild %s, keeping the previous program\n", e.name.c_str());
+  } else {
+    e.status = FAILED;
+    fprintf(stderr, "ERROR: failed to build %s\n", e.name.c_str());
+  }
+
+  e.build = 0; //kept as e.program or deleted by the check
+  shader_cache.build_ms += elapsed_ms(start);
+}
+
+bool shader_manager::watch(const std::string& directory)
+{
+#if defined(__linux__)
+  watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+  //editors either rewrite the file or rename a temporary over it
+  if(watch_fd < 0 || inotify_add_watch(watch_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+  {
+    fprintf(stderr, "ERROR: failed to watch %s for shader changes\n", directory.c_str());
+    if(watch_fd >= 0)
+      close(watch_fd);
+    watch_fd = -1;
+    return false;
+  }
+
+  watch_dir = directory;
+  return true;
+#else
+  fprintf(stderr, "shaders: hot reload is only supported on linux\n");
+  return false;
+#endif
+}
+
+// drains pending inotify events and restarts the builds of every program
+// using a touched file, once per poll however many events arrived
+void shader_manager::check_changes()
+{
+#if defined(__linux__)
+  if(watch_fd < 0)
+    return;
+
+  std::vector<bool> touched(programs.size(), false);
+  bool any = false;
+
+  alignas(inotify_event) char buf[4096];
+  ssize_t len;
+
+  while((len = read(watch_fd, buf, sizeof(buf))) > 0)
+  {
+    for(char* p = buf; p < buf + len; p += sizeof(inotify_event) + ((inotify_event*)p)->len)
+    {
+      const inotify_event* ev = (const inotify_event*)p;
+      if(!ev->len)
+        continue;
+
+      std::string path = watch_dir + "/" + ev->name;
+
+      //includes count too, editing a shared file rebuilds every user
+      for(size_t i = 0; i < programs.size(); ++i)
+        for(const std::string& dep : programs[i].deps)
+          if(dep == path)
+            touched[i] = any = true;
+    }
+  }
+
+  if(!any)
+    return;
+
+  for(size_t i = 0; i < programs.size(); ++i)
+  {
+    if(!touched[i])
+      continue;
+
+    start(programs[i]);
+    ++reloads;
+  }
+#endif
+}
+
+int shader_manager::poll()
+{
+  check_changes();
+
+  int pending = 0;
+  bool stalled = false;
+
+  for(entry& e : programs)
+  {
+    if(!e.build)
+      continue;
+
+    //without the extension there is no way to ask, so one program is
+    //finished per poll to spread the stall over several frames
+    GLint done = !stalled;
+    if(parallel)
+      glGetProgramiv(e.build, GL_COMPLETION_STATUS_KHR, &done);
+
+    if(done)
+    {
+      finish(e);
+      stalled = !parallel;
+    }
+
+    pending += e.build != 0;
+  }
+
+  return pending;
+}
+
+void shader_manager::wait_all()
+{
+  for(entry& e : programs)
+    if(e.build)
+      finish(e);
+}
+
+unsigned int shader_manager::wait(int handle)
+{
+  entry& e = programs[handle];
+  if(e.build)
+    finish(e);
+  return e.program;
+}
+
+unsigned int shader_manager::program(int handle) const
+{
+  return programs[handle].program;
+}
+
+shader_manager::status_t shader_manager::status(int handle) const
+{
+  return programs[handle].status;
+}
+
+void shader_variants::create(shader_manager& manager, const std::string& vshader_file, const std::string& fshader_file,
+                             std::initializer_list<const char*> features)
+{
+  this->manager      = &manager;
+  this->vshader_file = vshader_file;
+  this->fshader_file = fshader_file;
+  this->features.assign(features.begin(), features.end());
+
+  if(this->features.size() > (size_t)max_features)
+  {
+    fprintf(stderr, "ERROR: %s has more than %d features, the rest are ignored\n", fshader_file.c_str(), max_features);
+    this->features.resize(max_features);
+  }
+
+  for(int& h : handles)
+    h = -1;
+}
+
+int shader_variants::get(uint32_t mask)
+{
+  mask &= (1u << features.size()) - 1;
+
+  if(handles[mask] >= 0)
+    return handles[mask];
+
+  std::string defines;
+  for(size_t i = 0; i < features.size(); ++i)
+    if(mask & (1u << i))
+      defines += "#define " + features[i] + " 1\n";
+
+  handles[mask] = manager->submit(vshader_file, fshader_file, defines);
+  return handles[mask];
+}
+
+unsigned int shader_variants::program(uint32_t mask)
+{
+  unsigned int prg = manager->program(get(mask));
+  return prg ? prg : manager->program(get(0));
+}
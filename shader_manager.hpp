@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+#include <glad/gl.h>
+
+// compiles every program without waiting on any of them. compiles and
+// links are all issued at submit time, the driver works on them in the
+// background (on its own threads with KHR/ARB_parallel_shader_compile)
+// and poll() picks up the finished ones through GL_COMPLETION_STATUS, so
+// nothing blocks until a program is actually needed. programs found in
+// shader_cache are ready on submit.
+//
+// with watch(), sources edited on disk are rebuilt the same way and the
+// new program replaces the old one in the poll that sees it link. a
+// failed rebuild keeps the old program, so handles never go back to 0.
+struct shader_manager
+{
+  enum status_t
+  {
+    PENDING,
+    READY,
+    FAILED,
+  };
+
+  struct entry
+  {
+    std::string  name;
+    const char*  kind    = "";
+    std::string  files[2];
+    std::string  defines;    //injected after #version, part of the cache key
+    std::vector<std::string> deps; //every file the last load pulled in
+    GLenum       types[2] = {};
+    int          stages  = 0;
+
+    unsigned int program = 0; //the live program, what program() returns
+    unsigned int build   = 0; //in flight, first build or a reload
+    unsigned int shaders[2] = {};
+    uint64_t     key     = 0;
+    status_t     status  = PENDING;
+  };
+
+  // `load` resolves the extension entry point (glfwGetProcAddress)
+  void init(GLADloadfunc load);
+  void shutdown();
+
+  // `defines` is a block of #define lines specialising this program
+  int submit(const std::string& vshader_file, const std::string& fshader_file, const std::string& defines = "");
+  int submit_compute(const std::string& cshader_file, const std::string& defines = "");
+
+  // rebuild programs whose sources in `directory` change (linux only)
+  bool watch(const std::string& directory);
+
+  // finalises whatever finished, returns how many are still pending
+  int  poll();
+  void wait_all();
+
+  // the program once linked, 0 while pending or after a failure
+  unsigned int program(int handle) const;
+  status_t     status(int handle) const;
+
+  // blocks for this one program only
+  unsigned int wait(int handle);
+
+  void start(entry& e);
+  void finish(entry& e);
+  void discard(entry& e);
+  void check_changes();
+
+  std::vector<entry> programs;
+  bool parallel = false; //driver reports completion without blocking
+
+  std::string watch_dir;
+  int         watch_fd = -1;
+  int         reloads  = 0;
+};
+
+// every permutation of one program over up to max_features #ifdef flags.
+// a permutation is only compiled the first time its mask is asked for and
+// carries nothing but the code its flags enable. after that, picking it is
+// an array lookup.
+struct shader_variants
+{
+  static const int max_features = 6;
+
+  // bit i of a mask turns on features[i]
+  void create(shader_manager& manager, const std::string& vshader_file, const std::string& fshader_file,
+              std::initializer_list<const char*> features);
+
+  // the manager handle of this permutation, submitted on first use
+  int get(uint32_t mask);
+
+  // the permutation if it is linked, else the one without features
+  unsigned int program(uint32_t mask);
+
+  shader_manager*          manager = nullptr;
+  std::string              vshader_file;
+  std::string              fshader_file;
+  std::vector<std::string> features;
+  int                      handles[1 << max_features];
+};
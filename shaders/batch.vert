@@ -0,0 +1,35 @@
+#version 450
+
+layout(std140, binding = 0) uniform frame_block
+{
+  vec2  u_resolution;
+  float u_time;
+  float u_dt;
+};
+
+layout(std140, binding = 1) uniform view_block
+{
+  mat4 u_mvp;
+  mat4 u_view;
+  mat4 u_projection;
+  vec4 u_viewport;
+};
+
+//see batch_vertex, positions are already in world space
+layout(location = 0) in vec3 a_pos;
+layout(location = 1) in vec4 a_col;
+layout(location = 2) in vec2 a_uv;
+
+out vec4 v_col;
+out vec2 v_uv;
+
+void main()
+{
+  float aspect = u_resolution.x / u_resolution.y;
+  vec3 pos = a_pos;
+  pos.x /= aspect;
+
+  gl_Position = u_mvp * vec4(pos, 1.0);
+  v_col = a_col;
+  v_uv  = a_uv;
+}
@@ -1,22 +1,32 @@
 #version 450
 
-uniform vec2      u_resolution;
-uniform float     u_time;
+layout(std140, binding = 0) uniform frame_block
+{
+  vec2  u_resolution;
+  float u_time;
+  float u_dt;
+};
 
-uniform sampler2D u_tex0;
-uniform sampler2D u_tex1;
+layout(binding = 0) uniform sampler2D u_tex0;
+layout(binding = 1) uniform sampler2D u_tex1;
 
 in vec4 v_col;
 in vec2 v_uv;
 
 out vec4 fragColor;
 
+//variant flags, defined by shader_variants when requested:
+//  COLOR_EFFECT  animated screen space tint instead of the plain blend
+
 void main()
 {
+#ifdef COLOR_EFFECT
   vec2 uv  = gl_FragCoord.xy / u_resolution.xy;
   float d  = length(fract(uv));
   vec4 col = vec4(d * sin(u_time) + 1, (1.0 - d) * cos(1.25 * u_time) + 1, (1.0 - d) * sin(0.75 * u_time) + 1, 1.0);
 
-  //fragColor = texture(u_tex1, v_uv) * col* v_col; //v_col
+  fragColor = texture(u_tex1, v_uv) * col * v_col;
+#else
   fragColor = mix(texture(u_tex0, v_uv), texture(u_tex1, v_uv), 0.5);
+#endif
 }
@@ -1,11 +1,28 @@
 #version 450
 
-uniform mat4 u_mvp;
-uniform vec2 u_resolution;
+layout(std140, binding = 0) uniform frame_block
+{
+  vec2  u_resolution;
+  float u_time;
+  float u_dt;
+};
+
+layout(std140, binding = 1) uniform view_block
+{
+  mat4 u_mvp;
+  mat4 u_view;
+  mat4 u_projection;
+  vec4 u_viewport;
+};
+
+layout(location = 0) in vec3 a_pos;
+layout(location = 1) in vec4 a_col;
+layout(location = 2) in vec2 a_uv;
 
-in vec3 a_pos;
-in vec4 a_col;
-in vec2 a_uv;
+//per instance, see sprite_instance
+layout(location = 3) in vec2  a_offset;
+layout(location = 4) in vec2  a_scale;
+layout(location = 5) in float a_u_offset;
 
 out vec4 v_col;
 out vec2 v_uv;
@@ -13,10 +30,10 @@ out vec2 v_uv;
 void main()
 {
   float aspect = u_resolution.x / u_resolution.y;
-  vec3 pos = a_pos;
+  vec3 pos = vec3(a_pos.xy * a_scale + a_offset, a_pos.z);
   pos.x /= aspect;
 
   gl_Position = u_mvp * vec4(pos, 1.0); 
   v_col = a_col;
-  v_uv  = a_uv;
+  v_uv  = a_uv + vec2(a_u_offset, 0.0);
 }
@@ -0,0 +1,71 @@
+#include "sim.hpp"
+
+#include <cmath>
+
+float lerp(float a, float b, float t)
+{
+  return (b-a)*t + a;
+}
+
+float smoothstep(float x)
+{
+  return (x <= 0)? 0 : (x >= 1)? 1 : (6*pow(x, 2)-5*pow(x, 3));
+}
+
+void sim_step(sim_state& s, sim_input& input, float dt)
+{
+  s.time += dt;
+
+  s.cam_x -= input.scroll_x * 18.f / 60.f;
+  s.cam_y += input.scroll_y * 18.f / 60.f;
+  input.scroll_x = input.scroll_y = 0;
+
+  if(input.zoom_in) {
+    s.accel_time += dt;
+    s.cam_z -= lerp(0, 1.5, smoothstep(s.accel_time)) * dt;//1.5 is max velocity of the camera
+  } else if(input.zoom_out) {
+    s.accel_time += dt;
+    s.cam_z += lerp(0, 1.5, smoothstep(s.accel_time)) * dt;
+  } else {
+    s.accel_time = 0;
+  }
+}
+
+sim_state sim_interpolate(const sim_state& prev, const sim_state& curr, float alpha)
+{
+  sim_state s  = curr;
+  s.time       = prev.time + (curr.time - prev.time) * alpha;
+  s.cam_z      = lerp(prev.cam_z, curr.cam_z, alpha);
+  s.cam_x      = lerp(prev.cam_x, curr.cam_x, alpha);
+  s.cam_y      = lerp(prev.cam_y, curr.cam_y, alpha);
+  return s;
+}
+
+fixed_timestep::fixed_timestep(double tick_rate, int substeps)
+{
+  tick_dt      = 1.0 / tick_rate;
+  max_substeps = substeps;
+}
+
+int fixed_timestep::advance(double frame_dt)
+{
+  accumulator += frame_dt;
+
+  int ticks = (int)(accumulator / tick_dt);
+
+  if(ticks > max_substeps)
+  {
+    dropped_ticks += ticks - max_substeps;
+    ticks = max_substeps;
+    accumulator = std::fmod(accumulator, tick_dt);
+  } else {
+    accumulator -= ticks * tick_dt;
+  }
+
+  return ticks;
+}
+
+float fixed_timestep::alpha() const
+{
+  return (float)(accumulator / tick_dt);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+float lerp(float a, float b, float t);
+float smoothstep(float x);
+
+// everything the simulation owns. it is plain data so the renderer can keep
+// the previous and current tick and blend between them.
+struct sim_state
+{
+  double time       = 0;
+  float  cam_z      = 4;
+  float  cam_x      = 0; //camera target, driven by scrolling
+  float  cam_y      = 0;
+  float  accel_time = 0; //how long the camera has been accelerating
+};
+
+struct sim_input
+{
+  bool  zoom_in  = false;
+  bool  zoom_out = false;
+  float scroll_x = 0; //consumed by the first tick that sees it
+  float scroll_y = 0;
+};
+
+void sim_step(sim_state& state, sim_input& input, float dt);
+
+// continuous values are blended, discrete ones snap to the newest tick
+sim_state sim_interpolate(const sim_state& prev, const sim_state& curr, float alpha);
+
+// accumulates real frame time and hands out fixed ticks. at most
+// max_substeps ticks are run per frame, whatever is left over is dropped
+// so a long stall slows the simulation down instead of spiralling.
+struct fixed_timestep
+{
+  fixed_timestep(double tick_rate = 60.0, int max_substeps = 5);
+
+  int   advance(double frame_dt);
+  float alpha() const;
+
+  double tick_dt;
+  double accumulator = 0;
+  int    max_substeps;
+  long   dropped_ticks = 0;
+};
@@ -0,0 +1,225 @@
+#include "source_files.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "program_cache.hpp"
+
+source_library shader_library;
+
+bool read_file(const std::string& path, std::string& out)
+{
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if(fd < 0)
+    return false;
+
+  struct stat st;
+  if(fstat(fd, &st) != 0)
+  {
+    close(fd);
+    return false;
+  }
+
+  out.resize(st.st_size);
+
+  //one read normally covers it, the loop only handles short reads
+  size_t done = 0;
+  while(done < out.size())
+  {
+    ssize_t n = read(fd, &out[done], out.size() - done);
+    if(n <= 0)
+      break;
+    done += n;
+  }
+
+  close(fd);
+  out.resize(done);
+  return done == (size_t)st.st_size;
+}
+
+// content hash for whole files. fnv-1a goes a byte at a time through a
+// multiply chain, this mixes 32 bytes per step over four independent lanes
+// and finishes the tail with fnv.
+static uint64_t hash_text(const std::string& text)
+{
+  const uint64_t k = 0x9e3779b97f4a7c15ull;
+  uint64_t lanes[4] = {k, k ^ 1, k ^ 2, k ^ 3};
+
+  const char* p = text.data();
+  size_t n = text.size(), i = 0;
+
+  for(; i + 32 <= n; i += 32)
+  {
+    for(int l = 0; l < 4; ++l)
+    {
+      uint64_t w;
+      memcpy(&w, p + i + l * 8, 8);
+      lanes[l] = (lanes[l] ^ w) * k;
+      lanes[l] ^= lanes[l] >> 29;
+    }
+  }
+
+  uint64_t h = hash_bytes(lanes, sizeof(lanes));
+  h = hash_bytes(&n, sizeof(n), h);
+  return hash_bytes(p + i, n - i, h);
+}
+
+static std::string directory_of(const std::string& path)
+{
+  size_t slash = path.find_last_of('/');
+  return slash == std::string::npos ? "." : path.substr(0, slash);
+}
+
+// finds `#include "name"` lines. anything fancier (<>, macros, includes
+// inside block comments) is left to the glsl compiler to complain about.
+// only '#' characters are visited, lines are counted between directives.
+static void scan_includes(const std::string& path, source_library::file_record& f)
+{
+  f.includes.clear();
+
+  std::string dir = directory_of(path);
+  const char* t   = f.text.data();
+  size_t size     = f.text.size();
+
+  int    line    = 1;
+  size_t counted = 0;
+
+  for(const char* hash = (const char*)memchr(t, '#', size); hash; hash = (const char*)memchr(hash + 1, '#', t + size - hash - 1))
+  {
+    size_t at = hash - t;
+
+    size_t begin = at;
+    while(begin > 0 && (t[begin - 1] == ' ' || t[begin - 1] == '\t'))
+      --begin;
+
+    if((begin > 0 && t[begin - 1] != '\n') || size - at < 8 || memcmp(hash, "#include", 8) != 0)
+      continue;
+
+    const char* eol   = (const char*)memchr(hash, '\n', t + size - hash);
+    size_t      next  = eol ? eol - t + 1 : size;
+    const char* open  = (const char*)memchr(hash + 8, '"', t + next - hash - 8);
+    const char* close = open ? (const char*)memchr(open + 1, '"', t + next - open - 1) : nullptr;
+
+    if(!close)
+      continue;
+
+    line += (int)std::count(t + counted, t + begin, '\n');
+    counted = begin;
+
+    f.includes.push_back({begin, next, line + 1, dir + "/" + std::string(open + 1, close)});
+  }
+}
+
+// rereads the file if it changed on disk since the last look
+source_library::file_record* source_library::refresh(const std::string& path)
+{
+  struct stat st;
+  if(stat(path.c_str(), &st) != 0)
+  {
+    fprintf(stderr, "ERROR: failed to load file %s\n", path.c_str());
+    return nullptr;
+  }
+
+  file_record& f = files[path];
+  int64_t mtime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+
+  if(f.mtime == mtime && f.size == (int64_t)st.st_size)
+    return &f;
+
+  if(!read_file(path, f.text))
+  {
+    fprintf(stderr, "ERROR: failed to read file %s\n", path.c_str());
+    f.mtime = -1;
+    return nullptr;
+  }
+
+  f.mtime = mtime;
+  f.size  = st.st_size;
+  f.hash  = hash_text(f.text);
+  ++f.version;
+  ++reads;
+
+  scan_includes(path, f);
+  return &f;
+}
+
+bool source_library::expand(const std::string& path, int index, expansion& out)
+{
+  file_record* f = refresh(path);
+  if(!f)
+    return false;
+
+  out.source.hash = hash_bytes(&f->hash, sizeof(f->hash), out.source.hash);
+
+  //map references stay valid while included files are added
+  const std::string& text = f->text;
+  const std::vector<include_ref>& includes = f->includes;
+
+  size_t pos = 0;
+  for(const include_ref& inc : includes)
+  {
+    out.source.text.append(text, pos, inc.begin - pos);
+    pos = inc.end;
+
+    bool seen = false;
+    for(const std::string& file : out.source.files)
+      seen |= file == inc.path;
+
+    if(seen)
+      continue;
+
+    int child = (int)out.source.files.size();
+    out.source.files.push_back(inc.path);
+
+    //keep compiler errors pointing at the right file and line
+    out.source.text += "#line 1 " + std::to_string(child) + "\n";
+    if(!expand(inc.path, child, out))
+      return false;
+    if(!out.source.text.empty() && out.source.text.back() != '\n')
+      out.source.text += '\n';
+    out.source.text += "#line " + std::to_string(inc.next_line) + " " + std::to_string(index) + "\n";
+  }
+
+  out.source.text.append(text, pos, std::string::npos);
+  return true;
+}
+
+const shader_source* source_library::load(const std::string& path)
+{
+  auto it = roots.find(path);
+
+  if(it != roots.end())
+  {
+    expansion& e = it->second;
+    bool fresh = true;
+
+    for(size_t i = 0; i < e.source.files.size() && fresh; ++i)
+    {
+      file_record* f = refresh(e.source.files[i]);
+      fresh = f && f->version == e.versions[i];
+    }
+
+    if(fresh)
+      return &e.source;
+  }
+
+  expansion e;
+  e.source.files.push_back(path);
+
+  if(!expand(path, 0, e))
+  {
+    roots.erase(path);
+    return nullptr;
+  }
+
+  for(const std::string& file : e.source.files)
+    e.versions.push_back(files[file].version);
+
+  ++expansions;
+  expansion& stored = roots[path] = std::move(e);
+  return &stored.source;
+}
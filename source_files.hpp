@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// the whole file with one sized read, no per-line appends
+bool read_file(const std::string& path, std::string& out);
+
+// a root file with its #includes expanded
+struct shader_source
+{
+  std::string              text;
+  uint64_t                 hash = 0;  //of every file's contents, in include order
+  std::vector<std::string> files;     //root first, source string n of #line is files[n]
+};
+
+// shader sources with `#include "file"` resolved relative to the including
+// file. every file is read and scanned for includes once and then kept
+// until its size or mtime changes, every expansion is kept until one of
+// the files it pulled in changes. a repeated load costs one stat per file.
+// a file is only included once per expansion, which also breaks cycles.
+struct source_library
+{
+  struct include_ref
+  {
+    size_t      begin, end; //the directive line, newline included
+    int         next_line;  //line number after the directive
+    std::string path;
+  };
+
+  struct file_record
+  {
+    std::string              text;
+    uint64_t                 hash    = 0;
+    int64_t                  mtime   = -1;
+    int64_t                  size    = -1;
+    unsigned int             version = 0;
+    std::vector<include_ref> includes;
+  };
+
+  struct expansion
+  {
+    shader_source             source;
+    std::vector<unsigned int> versions; //of source.files when expanded
+  };
+
+  // null if the root or one of its includes can not be read. the result
+  // stays valid until the next load of the same path
+  const shader_source* load(const std::string& path);
+
+  file_record* refresh(const std::string& path);
+  bool expand(const std::string& path, int index, expansion& out);
+
+  std::unordered_map<std::string, file_record> files;
+  std::unordered_map<std::string, expansion>   roots;
+
+  int reads      = 0; //files read from disk
+  int expansions = 0; //roots rebuilt
+};
+
+extern source_library shader_library;
@@ -0,0 +1,343 @@
+#include "spatial_grid.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+#include "jobs.hpp"
+
+static const size_t grid_grain = 8192;
+
+//an unused slot, nan fails every comparison a query makes
+static const grid_item empty_slot = {std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::quiet_NaN(), ~0u};
+
+//room for a quarter more points before a cell overflows
+static inline uint32_t spare_slots(uint32_t count)
+{
+  return count / 4 + 2;
+}
+
+static inline collision_pair ordered_pair(uint32_t a, uint32_t b)
+{
+  return a < b ? collision_pair{a, b} : collision_pair{b, a};
+}
+
+void spatial_grid::configure(float size, float min_x, float min_y, float max_x, float max_y)
+{
+  if(size <= 0)
+  {
+    fprintf(stderr, "ERROR: grid cell size must be positive\n");
+    size = 1;
+  }
+
+  cell_size = size;
+  inv_cell  = 1.f / size;
+  origin_x  = min_x;
+  origin_y  = min_y;
+  cols      = (int)std::ceil((max_x - min_x) * inv_cell);
+  rows      = (int)std::ceil((max_y - min_y) * inv_cell);
+  cols      = cols < 1 ? 1 : cols;
+  rows      = rows < 1 ? 1 : rows;
+
+  cell_start.assign((size_t)cols * rows + 1, 0);
+  cell_count.assign((size_t)cols * rows, 0);
+  items.clear();
+  cell_of.clear();
+  slot_of.clear();
+}
+
+//truncation rounds (-1, 0) to 0, which the clamp would do anyway
+int spatial_grid::cell_x(float x) const
+{
+  int c = (int)((x - origin_x) * inv_cell);
+  return c < 0 ? 0 : c >= cols ? cols - 1 : c;
+}
+
+int spatial_grid::cell_y(float y) const
+{
+  int r = (int)((y - origin_y) * inv_cell);
+  return r < 0 ? 0 : r >= rows ? rows - 1 : r;
+}
+
+void spatial_grid::build(const float* x, const float* y, size_t count)
+{
+  cell_of.resize(count);
+  uint32_t* cells = cell_of.data();
+
+  jobs.parallel_for(count, grid_grain, [&](size_t begin, size_t end) {
+    for(size_t i = begin; i < end; ++i)
+      cells[i] = (uint32_t)(cell_y(y[i]) * cols + cell_x(x[i]));
+  });
+
+  //counting sort: histogram, exclusive prefix sum over count plus spare
+  //slots, scatter
+  size_t cells_total = (size_t)cols * rows;
+  cell_count.assign(cells_total, 0);
+  cell_start.resize(cells_total + 1);
+
+  for(size_t i = 0; i < count; ++i)
+    ++cell_count[cells[i]];
+
+  cell_start[0] = 0;
+  for(size_t c = 0; c < cells_total; ++c)
+    cell_start[c + 1] = cell_start[c] + cell_count[c] + spare_slots(cell_count[c]);
+
+  items.assign(cell_start[cells_total], empty_slot);
+  slot_of.resize(count);
+
+  std::vector<uint32_t> cursor(cell_start.begin(), cell_start.end() - 1);
+
+  for(size_t i = 0; i < count; ++i)
+  {
+    uint32_t slot = cursor[cells[i]]++;
+    items[slot]   = {x[i], y[i], (uint32_t)i};
+    slot_of[i]    = slot;
+  }
+}
+
+// gives the full cell `cell` one more slot, taken from the closest
+// following cell that has a spare one. every cell in between moves its
+// first point into the slot freed at its end and gives up its first slot
+// to the cell before it. false when no cell within reach has room.
+bool spatial_grid::borrow_slot(uint32_t cell)
+{
+  const uint32_t reach = 64;
+  uint32_t cells_total = (uint32_t)cell_count.size();
+  uint32_t donor = cell + 1;
+
+  while(donor < cells_total && donor - cell <= reach && cell_start[donor] + cell_count[donor] == cell_start[donor + 1])
+    ++donor;
+
+  if(donor >= cells_total || donor - cell > reach)
+    return false;
+
+  for(uint32_t k = donor; k > cell; --k)
+  {
+    uint32_t first = cell_start[k];
+    uint32_t end   = first + cell_count[k];
+
+    if(end != first)
+    {
+      items[end] = items[first];
+      slot_of[items[end].index] = end;
+    }
+
+    items[first] = empty_slot;
+    ++cell_start[k];
+  }
+
+  return true;
+}
+
+void spatial_grid::update(const float* x, const float* y, size_t count)
+{
+  moved = 0;
+
+  if(count != cell_of.size() || slot_of.size() != count)
+  {
+    build(x, y, count);
+    ++rebuilds;
+    return;
+  }
+
+  //refresh positions in place, each block of points lists the ones that
+  //left their cell
+  size_t blocks = (count + grid_grain - 1) / grid_grain;
+  block_moves.resize(blocks);
+
+  const uint32_t* cells = cell_of.data();
+  const uint32_t* slots = slot_of.data();
+  grid_item* out = items.data();
+
+  jobs.parallel_for(blocks, 1, [&](size_t first, size_t last) {
+    for(size_t b = first; b < last; ++b)
+    {
+      std::vector<uint32_t>& moves = block_moves[b];
+      moves.clear();
+
+      size_t end = (b + 1) * grid_grain < count ? (b + 1) * grid_grain : count;
+      for(size_t i = b * grid_grain; i < end; ++i)
+      {
+        out[slots[i]].x = x[i];
+        out[slots[i]].y = y[i];
+
+        if(cells[i] != (uint32_t)(cell_y(y[i]) * cols + cell_x(x[i])))
+          moves.push_back((uint32_t)i);
+      }
+    }
+  });
+
+  //take every mover out first, so a cell they leave has room for the
+  //ones arriving. the last point of the cell fills the hole.
+  for(const std::vector<uint32_t>& moves : block_moves)
+  {
+    for(uint32_t i : moves)
+    {
+      uint32_t cell = cell_of[i];
+      uint32_t last = cell_start[cell] + --cell_count[cell];
+      uint32_t slot = slot_of[i];
+
+      if(slot != last)
+      {
+        items[slot] = items[last];
+        slot_of[items[slot].index] = slot;
+      }
+
+      items[last] = empty_slot;
+      ++moved;
+    }
+  }
+
+  for(const std::vector<uint32_t>& moves : block_moves)
+  {
+    for(uint32_t i : moves)
+    {
+      uint32_t cell = (uint32_t)(cell_y(y[i]) * cols + cell_x(x[i]));
+
+      if(cell_start[cell] + cell_count[cell] == cell_start[cell + 1] && !borrow_slot(cell))
+      {
+        //no spare slot close by, a build sizes them for the new layout
+        build(x, y, count);
+        ++rebuilds;
+        return;
+      }
+
+      uint32_t slot = cell_start[cell] + cell_count[cell]++;
+      items[slot]   = {x[i], y[i], i};
+      slot_of[i]    = slot;
+      cell_of[i]    = cell;
+    }
+  }
+}
+
+void spatial_grid::query_rect(float min_x, float min_y, float max_x, float max_y, std::vector<uint32_t>& out) const
+{
+  int c0 = cell_x(min_x), c1 = cell_x(max_x);
+  int r0 = cell_y(min_y), r1 = cell_y(max_y);
+
+  for(int r = r0; r <= r1; ++r)
+  {
+    //a row of cells is one contiguous run of items, spare slots included
+    uint32_t begin = cell_start[r * cols + c0];
+    uint32_t end   = cell_start[r * cols + c1 + 1];
+
+    for(uint32_t s = begin; s < end; ++s)
+    {
+      const grid_item& it = items[s];
+      if(it.x >= min_x && it.x <= max_x && it.y >= min_y && it.y <= max_y)
+        out.push_back(it.index);
+    }
+  }
+}
+
+void spatial_grid::query_radius(float x, float y, float radius, std::vector<uint32_t>& out) const
+{
+  int c0 = cell_x(x - radius), c1 = cell_x(x + radius);
+  int r0 = cell_y(y - radius), r1 = cell_y(y + radius);
+  float r2 = radius * radius;
+
+  for(int r = r0; r <= r1; ++r)
+  {
+    uint32_t begin = cell_start[r * cols + c0];
+    uint32_t end   = cell_start[r * cols + c1 + 1];
+
+    for(uint32_t s = begin; s < end; ++s)
+    {
+      float dx = items[s].x - x, dy = items[s].y - y;
+      if(dx * dx + dy * dy <= r2)
+        out.push_back(items[s].index);
+    }
+  }
+}
+
+uint32_t spatial_grid::pick(float x, float y, float radius) const
+{
+  int c0 = cell_x(x - radius), c1 = cell_x(x + radius);
+  int r0 = cell_y(y - radius), r1 = cell_y(y + radius);
+
+  uint32_t best = ~0u;
+  float best_d2 = radius * radius;
+
+  for(int r = r0; r <= r1; ++r)
+  {
+    uint32_t begin = cell_start[r * cols + c0];
+    uint32_t end   = cell_start[r * cols + c1 + 1];
+
+    for(uint32_t s = begin; s < end; ++s)
+    {
+      float dx = items[s].x - x, dy = items[s].y - y;
+      float d2 = dx * dx + dy * dy;
+      if(d2 <= best_d2)
+      {
+        best_d2 = d2;
+        best    = items[s].index;
+      }
+    }
+  }
+
+  return best;
+}
+
+// pairs of cell (c, r) with itself and its forward neighbours
+static void broadphase_cell(const spatial_grid& g, int c, int r, float d2, std::vector<collision_pair>& pairs)
+{
+  //self, right, and the three cells of the row above
+  static const int forward[4][2] = {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+
+  const grid_item* items = g.items.data();
+  uint32_t begin = g.cell_start[r * g.cols + c];
+  uint32_t end   = begin + g.cell_count[r * g.cols + c];
+
+  for(uint32_t s = begin; s < end; ++s)
+  {
+    for(uint32_t t = s + 1; t < end; ++t)
+    {
+      float dx = items[s].x - items[t].x, dy = items[s].y - items[t].y;
+      if(dx * dx + dy * dy < d2)
+        pairs.push_back(ordered_pair(items[s].index, items[t].index));
+    }
+  }
+
+  for(const int* o : forward)
+  {
+    int nc = c + o[0], nr = r + o[1];
+    if(nc < 0 || nc >= g.cols || nr >= g.rows)
+      continue;
+
+    uint32_t nbegin = g.cell_start[nr * g.cols + nc];
+    uint32_t nend   = nbegin + g.cell_count[nr * g.cols + nc];
+
+    for(uint32_t s = begin; s < end; ++s)
+    {
+      for(uint32_t t = nbegin; t < nend; ++t)
+      {
+        float dx = items[s].x - items[t].x, dy = items[s].y - items[t].y;
+        if(dx * dx + dy * dy < d2)
+          pairs.push_back(ordered_pair(items[s].index, items[t].index));
+      }
+    }
+  }
+}
+
+void spatial_grid::broadphase(float distance, std::vector<collision_pair>& pairs)
+{
+  if(distance > cell_size)
+    fprintf(stderr, "ERROR: broadphase distance %f exceeds the cell size %f\n", distance, cell_size);
+
+  float d2 = distance * distance;
+
+  //every row writes its own list, concatenated in row order
+  row_pairs.resize(rows);
+
+  jobs.parallel_for(rows, 8, [&](size_t first, size_t last) {
+    for(size_t r = first; r < last; ++r)
+    {
+      row_pairs[r].clear();
+      for(int c = 0; c < cols; ++c)
+        broadphase_cell(*this, c, (int)r, d2, row_pairs[r]);
+    }
+  });
+
+  for(int r = 0; r < rows; ++r)
+    pairs.insert(pairs.end(), row_pairs[r].begin(), row_pairs[r].end());
+}
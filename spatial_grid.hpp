@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// a point as stored in its cell, position kept next to the index so a
+// query touches one cache line per few points
+struct grid_item
+{
+  float    x, y;
+  uint32_t index;
+};
+
+// pair of point indices reported by the broadphase, a < b
+struct collision_pair
+{
+  uint32_t a, b;
+};
+
+// uniform grid over 2d points (sprite positions). every cell is a range of
+// `items`, filled by a counting sort so the build is linear and the points
+// of one cell sit next to each other. points outside the configured area
+// land in the border cells.
+//
+// each cell range ends in a few spare slots, so update() can move a point
+// into another cell without shifting anything else. unused slots hold nan
+// positions, which every query comparison rejects.
+//
+// queries test positions only. bounds with extents are found by padding
+// the query by the largest half extent.
+struct spatial_grid
+{
+  void configure(float cell_size, float min_x, float min_y, float max_x, float max_y);
+
+  // full rebuild
+  void build(const float* x, const float* y, size_t count);
+
+  // the per frame path. positions are refreshed in place and only the
+  // points whose cell changed are moved, each by a swap out of the old
+  // cell and an append into the spare slots of the new one. falls back to
+  // build() when the count changed or a cell has no spare slot left.
+  void update(const float* x, const float* y, size_t count);
+
+  void query_rect(float min_x, float min_y, float max_x, float max_y, std::vector<uint32_t>& out) const;
+  void query_radius(float x, float y, float radius, std::vector<uint32_t>& out) const;
+
+  // closest point within `radius`, ~0u when there is none
+  uint32_t pick(float x, float y, float radius) const;
+
+  // every pair closer than `distance`, which must not exceed cell_size.
+  // each cell is tested against itself and its forward neighbours only,
+  // so a pair is reported once. rows run on the job system and the pairs
+  // are appended in row order.
+  void broadphase(float distance, std::vector<collision_pair>& pairs);
+
+  bool borrow_slot(uint32_t cell);
+
+  int cell_x(float x) const;
+  int cell_y(float y) const;
+
+  float cell_size = 1, inv_cell = 1;
+  float origin_x  = 0, origin_y = 0;
+  int   cols = 1, rows = 1;
+
+  std::vector<uint32_t> cell_start; //cols * rows + 1 offsets into items
+  std::vector<uint32_t> cell_count; //points in each cell, the rest is spare
+  std::vector<grid_item> items;     //points grouped by cell
+  std::vector<uint32_t> cell_of;    //per point, in input order
+  std::vector<uint32_t> slot_of;    //per point, its position in items
+
+  std::vector<std::vector<uint32_t>> block_moves; //update, points that changed cell
+  size_t moved    = 0; //by the last update
+  size_t rebuilds = 0; //updates that fell back to build()
+
+  std::vector<std::vector<collision_pair>> row_pairs; //broadphase, per row
+};
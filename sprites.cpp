@@ -0,0 +1,210 @@
+#include "sprites.hpp"
+
+#include <cmath>
+
+#include "jobs.hpp"
+#include "quantize.hpp"
+
+static const uint32_t dead = ~0u;
+
+sprite_handle sprite_store::create(const sprite_desc& d)
+{
+  uint32_t index;
+
+  if(!free_slots.empty())
+  {
+    index = free_slots.back();
+    free_slots.pop_back();
+  } else {
+    index = (uint32_t)slots.size();
+    slots.push_back({dead, 0});
+  }
+
+  slots[index].dense = (uint32_t)size();
+  dense_to_slot.push_back(index);
+
+  pos_x.push_back(d.x);
+  pos_y.push_back(d.y);
+  vel_x.push_back(d.vx);
+  vel_y.push_back(d.vy);
+  scale_x.push_back(d.sx);
+  scale_y.push_back(d.sy);
+  anim_time.push_back(0);
+  frame.push_back(d.frame);
+  texture.push_back(d.texture);
+  layer.push_back(d.layer);
+
+  return {index, slots[index].generation};
+}
+
+template <typename A>
+static void swap_remove(A& a, uint32_t i)
+{
+  a[i] = a.back();
+  a.pop_back();
+}
+
+void sprite_store::destroy(sprite_handle h)
+{
+  if(!alive(h))
+    return;
+
+  uint32_t i    = slots[h.index].dense;
+  uint32_t last = (uint32_t)size() - 1;
+
+  swap_remove(pos_x, i);
+  swap_remove(pos_y, i);
+  swap_remove(vel_x, i);
+  swap_remove(vel_y, i);
+  swap_remove(scale_x, i);
+  swap_remove(scale_y, i);
+  swap_remove(anim_time, i);
+  swap_remove(frame, i);
+  swap_remove(texture, i);
+  swap_remove(layer, i);
+  swap_remove(dense_to_slot, i);
+
+  if(i != last)
+    slots[dense_to_slot[i]].dense = i;
+
+  slots[h.index].dense = dead;
+  ++slots[h.index].generation;
+  free_slots.push_back(h.index);
+}
+
+bool sprite_store::alive(sprite_handle h) const
+{
+  return h.index < slots.size() && slots[h.index].generation == h.generation && slots[h.index].dense != dead;
+}
+
+uint32_t sprite_store::dense_index(sprite_handle h) const
+{
+  return alive(h) ? slots[h.index].dense : dead;
+}
+
+void sprite_store::clear()
+{
+  for(uint32_t slot : dense_to_slot)
+  {
+    slots[slot].dense = dead;
+    ++slots[slot].generation;
+    free_slots.push_back(slot);
+  }
+
+  pos_x.clear(); pos_y.clear();
+  vel_x.clear(); vel_y.clear();
+  scale_x.clear(); scale_y.clear();
+  anim_time.clear();
+  frame.clear(); texture.clear(); layer.clear();
+  dense_to_slot.clear();
+}
+
+void sprite_store::reserve(size_t n)
+{
+  pos_x.reserve(n); pos_y.reserve(n);
+  vel_x.reserve(n); vel_y.reserve(n);
+  scale_x.reserve(n); scale_y.reserve(n);
+  anim_time.reserve(n);
+  frame.reserve(n); texture.reserve(n); layer.reserve(n);
+  dense_to_slot.reserve(n);
+}
+
+//big enough to amortise a job, small enough to spread 100k+ sprites
+static const size_t sprite_grain = 4096;
+
+void sprites_animate(sprite_store& s, float dt)
+{
+  float*    __restrict t = s.anim_time.data();
+  uint16_t* __restrict f = s.frame.data();
+
+  jobs.parallel_for(s.size(), sprite_grain, [=](size_t begin, size_t end) {
+    for(size_t i = begin; i < end; ++i)
+    {
+      float next = t[i] + dt;
+      bool  flip = next >= sprite_duration;
+      t[i] = flip ? 0.f : next;
+      f[i] = flip ? (uint16_t)((f[i] + 1) % sprite_frames) : f[i];
+    }
+  });
+}
+
+void sprites_integrate(sprite_store& s, float dt, float bounds)
+{
+  float* __restrict px = s.pos_x.data();
+  float* __restrict py = s.pos_y.data();
+  float* __restrict vx = s.vel_x.data();
+  float* __restrict vy = s.vel_y.data();
+
+  jobs.parallel_for(s.size(), sprite_grain, [=](size_t begin, size_t end) {
+    //bounce off the world edges, branch free so it vectorises
+    for(size_t i = begin; i < end; ++i)
+    {
+      float x = px[i] + vx[i] * dt;
+      float y = py[i] + vy[i] * dt;
+      vx[i] = (x > bounds || x < -bounds) ? -vx[i] : vx[i];
+      vy[i] = (y > bounds || y < -bounds) ? -vy[i] : vy[i];
+      px[i] = x;
+      py[i] = y;
+    }
+  });
+}
+
+void sprites_update(sprite_store& s, float dt)
+{
+  sprites_animate(s, dt);
+  sprites_integrate(s, dt, 4.f);
+}
+
+void sprites_pack_instances(const sprite_store& s, sprite_instance* out)
+{
+  const float*    px = s.pos_x.data();
+  const float*    py = s.pos_y.data();
+  const float*    sx = s.scale_x.data();
+  const float*    sy = s.scale_y.data();
+  const uint16_t* f  = s.frame.data();
+  const uint16_t* tx = s.texture.data();
+  const uint8_t*  l  = s.layer.data();
+
+  jobs.parallel_for(s.size(), sprite_grain, [=](size_t begin, size_t end) {
+    for(size_t i = begin; i < end; ++i)
+    {
+      sprite_instance& o = out[i];
+      o.pos[0]       = px[i];
+      o.pos[1]       = py[i];
+      o.scale[0]     = {to_half(sx[i])};
+      o.scale[1]     = {to_half(sy[i])};
+      o.u_offset[0]  = (uint16_t)((f[i] * 65535u + sprite_frames / 2) / sprite_frames);
+      o.texture      = (uint8_t)tx[i];
+      o.layer        = l[i];
+    }
+  });
+}
+
+void sprites_pack_bounds(const sprite_store& s, sprite_bounds& out)
+{
+  size_t n = s.size();
+  out.center_x.resize(n);
+  out.center_y.resize(n);
+  out.extent_x.resize(n);
+  out.extent_y.resize(n);
+
+  const float* px = s.pos_x.data();
+  const float* py = s.pos_y.data();
+  const float* sx = s.scale_x.data();
+  const float* sy = s.scale_y.data();
+  float* cx = out.center_x.data();
+  float* cy = out.center_y.data();
+  float* ex = out.extent_x.data();
+  float* ey = out.extent_y.data();
+
+  //the quad spans [-0.5, 0.5] * scale around the position
+  jobs.parallel_for(n, sprite_grain, [=](size_t begin, size_t end) {
+    for(size_t i = begin; i < end; ++i)
+    {
+      cx[i] = px[i];
+      cy[i] = py[i];
+      ex[i] = std::fabs(sx[i]) * 0.5f;
+      ey[i] = std::fabs(sy[i]) * 0.5f;
+    }
+  });
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "vertex_layout.hpp"
+
+const int   sprite_frames   = 2;
+const float sprite_duration = 0.6f;
+
+// keeps every component array on a 32 byte boundary so update loops can be
+// vectorised with aligned loads
+template <typename T>
+struct aligned_allocator
+{
+  typedef T value_type;
+  static const size_t alignment = 32;
+
+  aligned_allocator() = default;
+  template <typename U> aligned_allocator(const aligned_allocator<U>&) {}
+
+  T* allocate(size_t n)
+  {
+    size_t bytes = (n * sizeof(T) + alignment - 1) / alignment * alignment;
+    void* p = aligned_alloc(alignment, bytes);
+    if(!p)
+      throw std::bad_alloc();
+    return (T*)p;
+  }
+
+  void deallocate(T* p, size_t) { free(p); }
+
+  template <typename U> struct rebind { typedef aligned_allocator<U> other; };
+  bool operator==(const aligned_allocator&) const { return true; }
+  bool operator!=(const aligned_allocator&) const { return false; }
+};
+
+template <typename T>
+using soa_array = std::vector<T, aligned_allocator<T>>;
+
+// stays valid across removals of other sprites, a stale handle is detected
+// through the generation
+struct sprite_handle
+{
+  uint32_t index      = ~0u;
+  uint32_t generation = 0;
+};
+
+struct sprite_desc
+{
+  float    x = 0, y = 0;
+  float    vx = 0, vy = 0;
+  float    sx = 1, sy = 1;
+  uint16_t frame   = 0;
+  uint16_t texture = 0;
+  uint8_t  layer   = 0;
+};
+
+// per instance record the sprite shader reads, see shaders/shader.vert.
+// positions stay float so large worlds keep sub-pixel precision, the rest
+// is half / normalised integers (16 bytes instead of 32).
+struct sprite_instance
+{
+  attrib<float, 2>                                pos;
+  attrib<half, 2>                                 scale;
+  attrib<uint16_t, 1, attrib_kind::NORMALIZED>    u_offset;
+
+  //not vertex attributes: the layer sort on the cpu and cull.comp read
+  //them from the record, the shader never does
+  uint8_t                                         texture;
+  uint8_t                                         layer;
+};
+
+VERTEX_LAYOUT(sprite_instance, pos, scale, u_offset);
+
+static_assert(sizeof(sprite_instance) == 16, "sprite_instance must stay 16 bytes");
+
+// structure of arrays sprite storage. live sprites are packed densely in
+// [0, size()), removal moves the last sprite into the hole.
+struct sprite_store
+{
+  sprite_handle create(const sprite_desc& desc);
+  void          destroy(sprite_handle h);
+  bool          alive(sprite_handle h) const;
+  uint32_t      dense_index(sprite_handle h) const;
+  size_t        size() const { return pos_x.size(); }
+  void          clear();
+  void          reserve(size_t n);
+
+  //dense component arrays
+  soa_array<float>    pos_x, pos_y;
+  soa_array<float>    vel_x, vel_y;
+  soa_array<float>    scale_x, scale_y;
+  soa_array<float>    anim_time;
+  soa_array<uint16_t> frame;
+  soa_array<uint16_t> texture;
+  soa_array<uint8_t>  layer;
+  std::vector<uint32_t> dense_to_slot;
+
+  struct slot
+  {
+    uint32_t dense;
+    uint32_t generation;
+  };
+
+  std::vector<slot>     slots;
+  std::vector<uint32_t> free_slots;
+};
+
+// flat culling bounds of every sprite (center, half extents), in the
+// layout cull_aabbs reads. filled next to the instances for the renderer.
+struct sprite_bounds
+{
+  soa_array<float> center_x, center_y;
+  soa_array<float> extent_x, extent_y;
+};
+
+// systems, each streams through the arrays it needs on the job system
+void sprites_animate(sprite_store& s, float dt);
+void sprites_integrate(sprite_store& s, float dt, float bounds);
+void sprites_update(sprite_store& s, float dt);
+
+void sprites_pack_instances(const sprite_store& s, sprite_instance* out);
+void sprites_pack_bounds(const sprite_store& s, sprite_bounds& out);
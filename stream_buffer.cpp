@@ -0,0 +1,81 @@
+#include "stream_buffer.hpp"
+
+#include <cstdio>
+
+bool stream_buffer::create(size_t size, GLbitfield extra_flags)
+{
+  region_size = size;
+
+  GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+  glCreateBuffers(1, &id);
+  glNamedBufferStorage(id, region_size * max_frames, nullptr, flags | extra_flags);
+  mapped = (unsigned char*)glMapNamedBufferRange(id, 0, region_size * max_frames, flags);
+
+  if(!mapped)
+  {
+    fprintf(stderr, "ERROR: failed to map stream buffer\n");
+    return false;
+  }
+
+  frame = 0;
+  head  = 0;
+  return true;
+}
+
+void stream_buffer::destroy()
+{
+  for(int i = 0; i < max_frames; ++i)
+  {
+    if(fences[i])
+      glDeleteSync(fences[i]);
+    fences[i] = nullptr;
+  }
+
+  if(id)
+  {
+    glUnmapNamedBuffer(id);
+    glDeleteBuffers(1, &id);
+  }
+
+  id     = 0;
+  mapped = nullptr;
+}
+
+void stream_buffer::begin_frame()
+{
+  GLsync& fence = fences[frame];
+
+  if(fence)
+  {
+    //only blocks when the cpu is max_frames ahead of the gpu
+    while(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+
+  head = 0;
+}
+
+void stream_buffer::end_frame()
+{
+  fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  frame = (frame + 1) % max_frames;
+}
+
+size_t stream_buffer::alloc(size_t size, size_t alignment, void** ptr)
+{
+  size_t offset = (head + alignment - 1) / alignment * alignment;
+
+  if(offset + size > region_size)
+  {
+    fprintf(stderr, "ERROR: stream buffer region overflow (%zu bytes requested)\n", size);
+    return (size_t)-1;
+  }
+
+  head = offset + size;
+  offset += region_size * frame;
+
+  *ptr = mapped + offset;
+  return offset;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <glad/gl.h>
+
+// persistently mapped ring buffer split into one region per frame in flight.
+// each region is fenced when the frame is submitted and waited on before it
+// gets rewritten, so the cpu never writes memory the gpu is still reading.
+struct stream_buffer
+{
+  static const int max_frames = 3;
+
+  bool  create(size_t region_size, GLbitfield extra_flags = 0);
+  void  destroy();
+
+  void  begin_frame();
+  void  end_frame();
+
+  // sub-allocate from the current frame region. returns the byte offset into
+  // the buffer (for glBindBufferRange / attrib offsets) and a write pointer,
+  // or (size_t)-1 when the region is full.
+  size_t alloc(size_t size, size_t alignment, void** ptr);
+
+  unsigned int id       = 0;
+  unsigned char* mapped = nullptr;
+  size_t region_size    = 0;
+  size_t head           = 0;
+  int    frame          = 0;
+  GLsync fences[max_frames] = {};
+};
@@ -0,0 +1,305 @@
+#include "sweep_prune.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+#include "jobs.hpp"
+#include "radix_sort.hpp"
+
+static const int    max_bands  = 4096;
+static const size_t sap_grain  = 4096;
+
+//float bits that compare like the floats as unsigned integers
+static inline uint32_t ordered_bits(float f)
+{
+  uint32_t u;
+  memcpy(&u, &f, sizeof(u));
+  return u & 0x80000000u ? ~u : u | 0x80000000u;
+}
+
+static inline collision_pair ordered_pair(uint32_t a, uint32_t b)
+{
+  return a < b ? collision_pair{a, b} : collision_pair{b, a};
+}
+
+int sweep_and_prune::band(float min_y) const
+{
+  //truncation rounds (-1, 0) to 0, which the clamp would do anyway
+  int b = (int)((min_y - band_origin) * inv_band);
+  return b < 0 ? 0 : b >= bands ? bands - 1 : b;
+}
+
+void sweep_and_prune::rebuild(const box_soa& b)
+{
+  size_t n = b.count;
+
+  float lo = 0, hi = 0, tallest = 0;
+  for(size_t i = 0; i < n; ++i)
+  {
+    lo = i == 0 || b.min_y[i] < lo ? b.min_y[i] : lo;
+    hi = i == 0 || b.min_y[i] > hi ? b.min_y[i] : hi;
+    tallest = std::max(tallest, b.max_y[i] - b.min_y[i]);
+  }
+
+  //headroom so boxes can grow a little before the next rebuild. boxes
+  //leaving [lo, hi] later clamp into the border bands, which stays correct.
+  band_height = tallest > 0 ? tallest * 1.25f : 1.f;
+  band_origin = lo;
+  bands       = (int)std::ceil((hi - lo) / band_height) + 1;
+  bands       = std::min(std::max(bands, 1), max_bands);
+  band_height = std::max(band_height, (hi - lo) / bands * 1.0001f);
+  inv_band    = 1.f / band_height;
+
+  std::vector<sort_item> items(n), temp(n);
+  band_of.resize(n);
+
+  for(size_t i = 0; i < n; ++i)
+  {
+    band_of[i] = (uint32_t)band(b.min_y[i]);
+    items[i]   = {(uint64_t)band_of[i] << 32 | ordered_bits(b.min_x[i]), (uint32_t)i, 0};
+  }
+
+  radix_sort(items.data(), temp.data(), n);
+
+  order.resize(n);
+  band_start.assign(bands + 1, 0);
+  for(size_t i = 0; i < n; ++i)
+  {
+    order[i] = items[i].value;
+    ++band_start[band_of[order[i]] + 1];
+  }
+
+  for(int k = 0; k < bands; ++k)
+    band_start[k + 1] += band_start[k];
+}
+
+// binary insertion sort of ids by min_x. in-order ids cost one compare,
+// the rest one search and a memmove over the ids they pass.
+static size_t insertion_sort(uint32_t* o, size_t len, const float* min_x)
+{
+  size_t moved = 0;
+
+  for(size_t i = 1; i < len; ++i)
+  {
+    uint32_t id  = o[i];
+    float    key = min_x[id];
+
+    if(min_x[o[i - 1]] <= key)
+      continue;
+
+    uint32_t* at = std::upper_bound(o, o + i, key, [&](float v, uint32_t e) { return v < min_x[e]; });
+    memmove(at + 1, at, (o + i - at) * sizeof(uint32_t));
+    *at = id;
+    moved += o + i - at;
+  }
+
+  return moved;
+}
+
+void sweep_and_prune::repair(const box_soa& b)
+{
+  size_t n = b.count;
+  std::vector<uint32_t> new_band(n);
+  uint32_t* nb = new_band.data();
+
+  jobs.parallel_for(n, sap_grain, [&](size_t begin, size_t end) {
+    for(size_t i = begin; i < end; ++i)
+      nb[i] = (uint32_t)band(b.min_y[i]);
+  });
+
+  //stable counting sort into (band, source) segments, source being where
+  //the box was last tick: the band below, this band, the band above, or
+  //further. every segment stays nearly sorted by x.
+  std::vector<uint32_t> seg_start(bands * 4 + 1, 0);
+
+  for(size_t i = 0; i < n; ++i)
+  {
+    int from = (int)band_of[i] - (int)nb[i];
+    int src  = from == -1 ? 0 : from == 0 ? 1 : from == 1 ? 2 : 3;
+    ++seg_start[nb[i] * 4 + src + 1];
+  }
+
+  for(int s = 0; s < bands * 4; ++s)
+    seg_start[s + 1] += seg_start[s];
+
+  std::vector<uint32_t> cursor(seg_start.begin(), seg_start.end() - 1);
+  scratch.resize(n);
+
+  for(size_t i = 0; i < n; ++i)
+  {
+    uint32_t id   = order[i];
+    int      from = (int)band_of[id] - (int)nb[id];
+    int      src  = from == -1 ? 0 : from == 0 ? 1 : from == 1 ? 2 : 3;
+    scratch[cursor[nb[id] * 4 + src]++] = id;
+  }
+
+  order.swap(scratch);
+  band_of.swap(new_band);
+
+  for(int k = 0; k <= bands; ++k)
+    band_start[k] = seg_start[k * 4];
+
+  //fix the x order inside each segment (boxes passing each other), then
+  //merge the segments, which is linear in the band size
+  std::vector<size_t> band_moves(bands, 0);
+  const float* min_x = b.min_x;
+  auto by_x = [&](uint32_t l, uint32_t r) { return min_x[l] < min_x[r]; };
+
+  jobs.parallel_for(bands, 16, [&](size_t first, size_t last) {
+    for(size_t k = first; k < last; ++k)
+    {
+      uint32_t* o = order.data();
+      const uint32_t* seg = &seg_start[k * 4];
+
+      for(int s = 0; s < 4; ++s)
+        band_moves[k] += insertion_sort(o + seg[s], seg[s + 1] - seg[s], min_x);
+
+      for(int s = 1; s < 4; ++s)
+      {
+        if(seg[s + 1] > seg[s] && seg[s] > seg[0])
+        {
+          std::inplace_merge(o + seg[0], o + seg[s], o + seg[s + 1], by_x);
+          band_moves[k] += seg[s + 1] - seg[0];
+        }
+      }
+    }
+  });
+
+  for(size_t m : band_moves)
+    moves += m;
+}
+
+// tests box i against the x-sorted run [j, end), stopping at the first
+// box that starts past i's right edge
+static void scan_run(const sweep_and_prune& sap, size_t i, size_t j, size_t end, std::vector<collision_pair>& out)
+{
+  const float* min_x = sap.sorted_min_x.data();
+  const float* min_y = sap.sorted_min_y.data();
+  const float* max_y = sap.sorted_max_y.data();
+  const uint32_t* order = sap.order.data();
+
+  float ax1 = sap.sorted_max_x[i];
+  float ay0 = min_y[i], ay1 = max_y[i];
+
+#if defined(__AVX__)
+  __m256 vax1 = _mm256_set1_ps(ax1);
+  __m256 vay0 = _mm256_set1_ps(ay0);
+  __m256 vay1 = _mm256_set1_ps(ay1);
+
+  for(; j + 8 <= end; j += 8)
+  {
+    //sorted by min_x, so the lanes still inside the x interval are a prefix
+    __m256 in_x = _mm256_cmp_ps(_mm256_loadu_ps(min_x + j), vax1, _CMP_LE_OQ);
+    __m256 in_y = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(min_y + j), vay1, _CMP_LE_OQ),
+                                _mm256_cmp_ps(_mm256_loadu_ps(max_y + j), vay0, _CMP_GE_OQ));
+
+    unsigned int x_mask = (unsigned int)_mm256_movemask_ps(in_x);
+    unsigned int mask   = (unsigned int)_mm256_movemask_ps(_mm256_and_ps(in_x, in_y));
+
+    while(mask)
+    {
+      out.push_back(ordered_pair(order[i], order[j + __builtin_ctz(mask)]));
+      mask &= mask - 1;
+    }
+
+    if(x_mask != 0xff)
+      return;
+  }
+#endif
+
+  for(; j < end && min_x[j] <= ax1; ++j)
+  {
+    if(min_y[j] <= ay1 && max_y[j] >= ay0)
+      out.push_back(ordered_pair(order[i], order[j]));
+  }
+}
+
+// band k against itself and against band k + 1. across bands each pair is
+// found from the box with the smaller min_x (ties go to band k), with two
+// cursors that only move forward.
+static void sweep_band(const sweep_and_prune& sap, int k, std::vector<collision_pair>& out)
+{
+  const float* min_x = sap.sorted_min_x.data();
+
+  size_t begin = sap.band_start[k], end = sap.band_start[k + 1];
+
+  for(size_t i = begin; i < end; ++i)
+    scan_run(sap, i, i + 1, end, out);
+
+  if(k + 1 >= sap.bands)
+    return;
+
+  size_t up_begin = end, up_end = sap.band_start[k + 2];
+
+  size_t j = up_begin;
+  for(size_t i = begin; i < end; ++i)
+  {
+    while(j < up_end && min_x[j] < min_x[i])
+      ++j;
+    scan_run(sap, i, j, up_end, out);
+  }
+
+  size_t i = begin;
+  for(size_t u = up_begin; u < up_end; ++u)
+  {
+    while(i < end && min_x[i] <= min_x[u])
+      ++i;
+    scan_run(sap, u, i, end, out);
+  }
+}
+
+void sweep_and_prune::update(const box_soa& b, std::vector<collision_pair>& pairs)
+{
+  moves   = 0;
+  rebuilt = false;
+
+  float tallest = 0;
+  for(size_t i = 0; i < b.count; ++i)
+    tallest = std::max(tallest, b.max_y[i] - b.min_y[i]);
+
+  if(order.size() != b.count || tallest > band_height)
+  {
+    rebuild(b);
+    rebuilt = true;
+  } else {
+    repair(b);
+  }
+
+  size_t n = b.count;
+  sorted_min_x.resize(n);
+  sorted_max_x.resize(n);
+  sorted_min_y.resize(n);
+  sorted_max_y.resize(n);
+
+  const uint32_t* o = order.data();
+  jobs.parallel_for(n, sap_grain, [&](size_t begin, size_t end) {
+    for(size_t i = begin; i < end; ++i)
+    {
+      uint32_t id = o[i];
+      sorted_min_x[i] = b.min_x[id];
+      sorted_max_x[i] = b.max_x[id];
+      sorted_min_y[i] = b.min_y[id];
+      sorted_max_y[i] = b.max_y[id];
+    }
+  });
+
+  //every band writes its own list, concatenated in band order
+  band_pairs.resize(bands);
+
+  jobs.parallel_for(bands, 8, [&](size_t first, size_t last) {
+    for(size_t k = first; k < last; ++k)
+    {
+      band_pairs[k].clear();
+      sweep_band(*this, (int)k, band_pairs[k]);
+    }
+  });
+
+  pairs.clear();
+  for(int k = 0; k < bands; ++k)
+    pairs.insert(pairs.end(), band_pairs[k].begin(), band_pairs[k].end());
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "spatial_grid.hpp"
+
+// structure of arrays 2d boxes
+struct box_soa
+{
+  const float* min_x = nullptr;
+  const float* min_y = nullptr;
+  const float* max_x = nullptr;
+  const float* max_y = nullptr;
+  size_t count = 0;
+};
+
+// sort and sweep broadphase. boxes are split into horizontal bands at
+// least as tall as the tallest box, so a box can only overlap boxes of its
+// own band and the next one up. inside a band boxes are kept sorted by
+// min_x and swept along x, 8 candidates at a time with avx.
+//
+// the order survives between ticks and is repaired instead of rebuilt: a
+// stable counting sort moves the boxes that changed band into their own
+// segment of the new band, a binary insertion sort fixes the x order of
+// each segment and the segments are merged. all close to linear while
+// boxes move a little per tick. a full radix sort (which also picks
+// the band layout) runs on the first tick, when the count changes, or
+// when a box outgrows the band height.
+struct sweep_and_prune
+{
+  // every overlapping pair, a < b
+  void update(const box_soa& boxes, std::vector<collision_pair>& pairs);
+
+  void rebuild(const box_soa& boxes);
+  void repair(const box_soa& boxes);
+  int  band(float min_y) const;
+
+  //band layout, chosen by rebuild()
+  float band_origin = 0;
+  float band_height = 0;
+  float inv_band    = 1;
+  int   bands       = 0;
+
+  std::vector<uint32_t> order;      //box indices sorted by (band, min_x)
+  std::vector<uint32_t> band_start; //bands + 1 offsets into order
+  std::vector<uint32_t> band_of;    //per box, as of the last update
+  std::vector<uint32_t> scratch;
+
+  //boxes gathered in sorted order so the sweep reads them linearly
+  std::vector<float> sorted_min_x, sorted_max_x, sorted_min_y, sorted_max_y;
+
+  //per tick counters
+  size_t moves   = 0;
+  bool   rebuilt = false;
+
+  std::vector<std::vector<collision_pair>> band_pairs;
+};
@@ -0,0 +1,669 @@
+#include "texture_compress.hpp"
+
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "jobs.hpp"
+
+// channel planar copy of a block, what the index search works on
+struct block_pixels
+{
+  alignas(32) int32_t c[4][16]; //r, g, b, a
+};
+
+static void split_block(const uint8_t* rgba, block_pixels& b)
+{
+  for(int i = 0; i < 16; ++i)
+    for(int c = 0; c < 4; ++c)
+      b.c[c][i] = rgba[i * 4 + c];
+}
+
+// nearest palette entry for every pixel over the first CH channels,
+// returns the summed squared error of the block
+template <int CH>
+static int select_indices(const block_pixels& b, const int32_t (*palette)[4], int count, uint8_t* indices)
+{
+#if defined(__AVX2__)
+  int total = 0;
+
+  for(int half = 0; half < 2; ++half)
+  {
+    __m256i ch[CH];
+    for(int c = 0; c < CH; ++c)
+      ch[c] = _mm256_load_si256((const __m256i*)&b.c[c][half * 8]);
+
+    __m256i best = _mm256_set1_epi32(INT_MAX);
+    __m256i best_index = _mm256_setzero_si256();
+
+    for(int k = 0; k < count; ++k)
+    {
+      __m256i d = _mm256_setzero_si256();
+      for(int c = 0; c < CH; ++c)
+      {
+        __m256i t = _mm256_sub_epi32(ch[c], _mm256_set1_epi32(palette[k][c]));
+        d = _mm256_add_epi32(d, _mm256_mullo_epi32(t, t));
+      }
+
+      __m256i closer = _mm256_cmpgt_epi32(best, d);
+      best       = _mm256_min_epi32(best, d);
+      best_index = _mm256_blendv_epi8(best_index, _mm256_set1_epi32(k), closer);
+    }
+
+    alignas(32) int32_t err[8], index[8];
+    _mm256_store_si256((__m256i*)err, best);
+    _mm256_store_si256((__m256i*)index, best_index);
+
+    for(int i = 0; i < 8; ++i)
+    {
+      indices[half * 8 + i] = (uint8_t)index[i];
+      total += err[i];
+    }
+  }
+
+  return total;
+#else
+  int total = 0;
+
+  for(int i = 0; i < 16; ++i)
+  {
+    int best = INT_MAX, best_index = 0;
+
+    for(int k = 0; k < count; ++k)
+    {
+      int d = 0;
+      for(int c = 0; c < CH; ++c)
+      {
+        int t = b.c[c][i] - palette[k][c];
+        d += t * t;
+      }
+
+      if(d < best)
+      {
+        best       = d;
+        best_index = k;
+      }
+    }
+
+    indices[i] = (uint8_t)best_index;
+    total += best;
+  }
+
+  return total;
+#endif
+}
+
+static float clampf(float v, float lo, float hi)
+{
+  return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// endpoints at the corners of the bounding box, inset a little since the
+// extremes are rarely hit exactly. channels that fall while the widest
+// one rises get their ends swapped so the line follows the colours.
+template <int CH>
+static void bbox_endpoints(const block_pixels& b, float* e0, float* e1)
+{
+  float lo[4], hi[4], mean[4];
+  int widest = 0;
+
+  for(int c = 0; c < CH; ++c)
+  {
+    int mn = 255, mx = 0, sum = 0;
+    for(int i = 0; i < 16; ++i)
+    {
+      mn = b.c[c][i] < mn ? b.c[c][i] : mn;
+      mx = b.c[c][i] > mx ? b.c[c][i] : mx;
+      sum += b.c[c][i];
+    }
+
+    float inset = (mx - mn) / 16.f;
+    lo[c]   = mn + inset;
+    hi[c]   = mx - inset;
+    mean[c] = sum / 16.f;
+
+    if(hi[c] - lo[c] > hi[widest] - lo[widest])
+      widest = c;
+  }
+
+  for(int c = 0; c < CH; ++c)
+  {
+    float cov = 0;
+    for(int i = 0; i < 16; ++i)
+      cov += (b.c[c][i] - mean[c]) * (b.c[widest][i] - mean[widest]);
+
+    e0[c] = cov < 0 ? hi[c] : lo[c];
+    e1[c] = cov < 0 ? lo[c] : hi[c];
+  }
+}
+
+// endpoints at the extremes of the pixels projected on the principal axis
+template <int CH>
+static void pca_endpoints(const block_pixels& b, float* e0, float* e1)
+{
+  float mean[4] = {};
+  for(int c = 0; c < CH; ++c)
+  {
+    for(int i = 0; i < 16; ++i)
+      mean[c] += b.c[c][i];
+    mean[c] /= 16.f;
+  }
+
+  float cov[4][4] = {};
+  for(int i = 0; i < 16; ++i)
+    for(int r = 0; r < CH; ++r)
+      for(int c = r; c < CH; ++c)
+        cov[r][c] += (b.c[r][i] - mean[r]) * (b.c[c][i] - mean[c]);
+
+  for(int r = 0; r < CH; ++r)
+    for(int c = 0; c < r; ++c)
+      cov[r][c] = cov[c][r];
+
+  //power iteration, started off the bounding box diagonal
+  float axis[4], lo[4], hi[4];
+  bbox_endpoints<CH>(b, lo, hi);
+  for(int c = 0; c < CH; ++c)
+    axis[c] = hi[c] - lo[c] + 1e-3f;
+
+  for(int it = 0; it < 8; ++it)
+  {
+    float next[4] = {}, len = 0;
+    for(int r = 0; r < CH; ++r)
+    {
+      for(int c = 0; c < CH; ++c)
+        next[r] += cov[r][c] * axis[c];
+      len = fabsf(next[r]) > len ? fabsf(next[r]) : len;
+    }
+
+    if(len < 1e-6f)
+      break;
+
+    for(int c = 0; c < CH; ++c)
+      axis[c] = next[c] / len;
+  }
+
+  float norm = 0;
+  for(int c = 0; c < CH; ++c)
+    norm += axis[c] * axis[c];
+
+  if(norm < 1e-12f)
+  {
+    for(int c = 0; c < CH; ++c)
+      e0[c] = e1[c] = mean[c];
+    return;
+  }
+
+  float tmin = 1e30f, tmax = -1e30f;
+  for(int i = 0; i < 16; ++i)
+  {
+    float t = 0;
+    for(int c = 0; c < CH; ++c)
+      t += (b.c[c][i] - mean[c]) * axis[c];
+    tmin = t < tmin ? t : tmin;
+    tmax = t > tmax ? t : tmax;
+  }
+
+  for(int c = 0; c < CH; ++c)
+  {
+    e0[c] = clampf(mean[c] + axis[c] * tmin / norm, 0, 255);
+    e1[c] = clampf(mean[c] + axis[c] * tmax / norm, 0, 255);
+  }
+}
+
+// endpoints that best reproduce the pixels for fixed indices, `weights`
+// gives how much of e1 each index blends in. false when the system is
+// degenerate (all pixels on one index).
+template <int CH>
+static bool refine_endpoints(const block_pixels& b, const uint8_t* indices, const float* weights, float* e0, float* e1)
+{
+  float aa = 0, bb = 0, ab = 0;
+  float ax[4] = {}, bx[4] = {};
+
+  for(int i = 0; i < 16; ++i)
+  {
+    float w1 = weights[indices[i]];
+    float w0 = 1.f - w1;
+
+    aa += w0 * w0;
+    bb += w1 * w1;
+    ab += w0 * w1;
+
+    for(int c = 0; c < CH; ++c)
+    {
+      ax[c] += w0 * b.c[c][i];
+      bx[c] += w1 * b.c[c][i];
+    }
+  }
+
+  float det = aa * bb - ab * ab;
+  if(fabsf(det) < 1e-6f)
+    return false;
+
+  for(int c = 0; c < CH; ++c)
+  {
+    e0[c] = clampf((ax[c] * bb - bx[c] * ab) / det, 0, 255);
+    e1[c] = clampf((bx[c] * aa - ax[c] * ab) / det, 0, 255);
+  }
+
+  return true;
+}
+
+static int refinements(bc_quality quality)
+{
+  return quality == BC_FAST ? 0 : (quality == BC_NORMAL ? 1 : 3);
+}
+
+//
+// bc1
+//
+
+static uint16_t pack565(const float* c)
+{
+  int r = (int)(c[0] * 31.f / 255.f + 0.5f);
+  int g = (int)(c[1] * 63.f / 255.f + 0.5f);
+  int b = (int)(c[2] * 31.f / 255.f + 0.5f);
+  return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void unpack565(uint16_t v, int32_t* c)
+{
+  int r = v >> 11, g = (v >> 5) & 63, b = v & 31;
+  c[0] = (r << 3) | (r >> 2);
+  c[1] = (g << 2) | (g >> 4);
+  c[2] = (b << 3) | (b >> 2);
+  c[3] = 255;
+}
+
+static const float bc1_weights[4] = {0.f, 1.f, 1.f / 3.f, 2.f / 3.f};
+
+// quantizes, orders the endpoints for four colour mode and picks indices.
+// equal endpoints would mean three colour mode, every pixel uses 0 then.
+static int bc1_try(const block_pixels& b, const float* e0, const float* e1, uint16_t& c0, uint16_t& c1, uint8_t* indices)
+{
+  c0 = pack565(e0);
+  c1 = pack565(e1);
+
+  if(c0 < c1)
+  {
+    uint16_t t = c0;
+    c0 = c1;
+    c1 = t;
+  }
+
+  int32_t palette[4][4];
+  unpack565(c0, palette[0]);
+  unpack565(c1, palette[1]);
+
+  for(int c = 0; c < 3; ++c)
+  {
+    palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+    palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+  }
+
+  return select_indices<3>(b, palette, c0 == c1 ? 1 : 4, indices);
+}
+
+void encode_bc1_block(const uint8_t* rgba, uint8_t* out, bc_quality quality)
+{
+  block_pixels b;
+  split_block(rgba, b);
+
+  float e0[4], e1[4];
+  if(quality == BC_FAST)
+    bbox_endpoints<3>(b, e0, e1);
+  else
+    pca_endpoints<3>(b, e0, e1);
+
+  uint16_t c0, c1;
+  uint8_t indices[16];
+  int best = bc1_try(b, e0, e1, c0, c1, indices);
+
+  for(int it = 0; it < refinements(quality); ++it)
+  {
+    if(!refine_endpoints<3>(b, indices, bc1_weights, e0, e1))
+      break;
+
+    uint16_t t0, t1;
+    uint8_t t_indices[16];
+    int err = bc1_try(b, e0, e1, t0, t1, t_indices);
+
+    if(err >= best)
+      break;
+
+    best = err;
+    c0   = t0;
+    c1   = t1;
+    memcpy(indices, t_indices, 16);
+  }
+
+  uint32_t bits = 0;
+  for(int i = 0; i < 16; ++i)
+    bits |= (uint32_t)indices[i] << (i * 2);
+
+  out[0] = c0 & 0xFF;
+  out[1] = c0 >> 8;
+  out[2] = c1 & 0xFF;
+  out[3] = c1 >> 8;
+  memcpy(out + 4, &bits, 4); //little endian
+}
+
+void decode_bc1_block(const uint8_t* in, uint8_t* rgba)
+{
+  uint16_t c0 = in[0] | (in[1] << 8);
+  uint16_t c1 = in[2] | (in[3] << 8);
+  uint32_t bits;
+  memcpy(&bits, in + 4, 4);
+
+  int32_t palette[4][4];
+  unpack565(c0, palette[0]);
+  unpack565(c1, palette[1]);
+
+  for(int c = 0; c < 3; ++c)
+  {
+    if(c0 > c1)
+    {
+      palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+      palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    } else {
+      palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+      palette[3][c] = 0;
+    }
+  }
+  palette[2][3] = 255;
+  palette[3][3] = c0 > c1 ? 255 : 0;
+
+  for(int i = 0; i < 16; ++i)
+    for(int c = 0; c < 4; ++c)
+      rgba[i * 4 + c] = (uint8_t)palette[(bits >> (i * 2)) & 3][c];
+}
+
+//
+// bc7 mode 6
+//
+
+static const int bc7_weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+static const float bc7_weights[16] =
+{
+  0 / 64.f, 4 / 64.f, 9 / 64.f, 13 / 64.f, 17 / 64.f, 21 / 64.f, 26 / 64.f, 30 / 64.f,
+  34 / 64.f, 38 / 64.f, 43 / 64.f, 47 / 64.f, 51 / 64.f, 55 / 64.f, 60 / 64.f, 64 / 64.f,
+};
+
+struct bc7_endpoints
+{
+  int q[2][4]; //7 bit per channel
+  int p[2];    //shared lsb per endpoint
+};
+
+static void bc7_quantize(const float* e, int p, int* q)
+{
+  for(int c = 0; c < 4; ++c)
+  {
+    int v = (int)floorf((e[c] - p) / 2.f + 0.5f);
+    q[c] = v < 0 ? 0 : (v > 127 ? 127 : v);
+  }
+}
+
+static float bc7_quantize_error(const float* e, int p, const int* q)
+{
+  float err = 0;
+  for(int c = 0; c < 4; ++c)
+  {
+    float d = ((q[c] << 1) | p) - e[c];
+    err += d * d;
+  }
+  return err;
+}
+
+static int bc7_evaluate(const block_pixels& b, const bc7_endpoints& ep, uint8_t* indices)
+{
+  int32_t palette[16][4];
+  for(int c = 0; c < 4; ++c)
+  {
+    int v0 = (ep.q[0][c] << 1) | ep.p[0];
+    int v1 = (ep.q[1][c] << 1) | ep.p[1];
+
+    for(int k = 0; k < 16; ++k)
+      palette[k][c] = ((64 - bc7_weights4[k]) * v0 + bc7_weights4[k] * v1 + 32) >> 6;
+  }
+
+  return select_indices<4>(b, palette, 16, indices);
+}
+
+// p-bits by smallest endpoint rounding error, or at BC_HIGH by trying all
+// four combinations on the block
+static int bc7_try(const block_pixels& b, const float* e0, const float* e1, bc_quality quality, bc7_endpoints& ep, uint8_t* indices)
+{
+  if(quality != BC_HIGH)
+  {
+    const float* e[2] = {e0, e1};
+    for(int i = 0; i < 2; ++i)
+    {
+      int q0[4], q1[4];
+      bc7_quantize(e[i], 0, q0);
+      bc7_quantize(e[i], 1, q1);
+
+      bool odd = bc7_quantize_error(e[i], 1, q1) < bc7_quantize_error(e[i], 0, q0);
+      ep.p[i] = odd;
+      memcpy(ep.q[i], odd ? q1 : q0, sizeof(q0));
+    }
+
+    return bc7_evaluate(b, ep, indices);
+  }
+
+  int best = INT_MAX;
+
+  for(int combo = 0; combo < 4; ++combo)
+  {
+    bc7_endpoints t;
+    t.p[0] = combo & 1;
+    t.p[1] = combo >> 1;
+    bc7_quantize(e0, t.p[0], t.q[0]);
+    bc7_quantize(e1, t.p[1], t.q[1]);
+
+    uint8_t t_indices[16];
+    int err = bc7_evaluate(b, t, t_indices);
+
+    if(err < best)
+    {
+      best = err;
+      ep   = t;
+      memcpy(indices, t_indices, 16);
+    }
+  }
+
+  return best;
+}
+
+struct bit_writer
+{
+  uint8_t* out;
+  int      pos = 0;
+
+  void put(uint32_t value, int bits)
+  {
+    for(int i = 0; i < bits; ++i, ++pos)
+      if(value & (1u << i))
+        out[pos >> 3] |= 1 << (pos & 7);
+  }
+};
+
+struct bit_reader
+{
+  const uint8_t* in;
+  int            pos = 0;
+
+  uint32_t get(int bits)
+  {
+    uint32_t v = 0;
+    for(int i = 0; i < bits; ++i, ++pos)
+      v |= (uint32_t)((in[pos >> 3] >> (pos & 7)) & 1) << i;
+    return v;
+  }
+};
+
+void encode_bc7_block(const uint8_t* rgba, uint8_t* out, bc_quality quality)
+{
+  block_pixels b;
+  split_block(rgba, b);
+
+  float e0[4], e1[4];
+  if(quality == BC_FAST)
+    bbox_endpoints<4>(b, e0, e1);
+  else
+    pca_endpoints<4>(b, e0, e1);
+
+  bc7_endpoints ep;
+  uint8_t indices[16];
+  int best = bc7_try(b, e0, e1, quality, ep, indices);
+
+  for(int it = 0; it < refinements(quality); ++it)
+  {
+    if(!refine_endpoints<4>(b, indices, bc7_weights, e0, e1))
+      break;
+
+    bc7_endpoints t;
+    uint8_t t_indices[16];
+    int err = bc7_try(b, e0, e1, quality, t, t_indices);
+
+    if(err >= best)
+      break;
+
+    best = err;
+    ep   = t;
+    memcpy(indices, t_indices, 16);
+  }
+
+  //the anchor index is stored with 3 bits, its top bit has to be 0
+  if(indices[0] & 8)
+  {
+    bc7_endpoints s = ep;
+    memcpy(ep.q[0], s.q[1], sizeof(s.q[0]));
+    memcpy(ep.q[1], s.q[0], sizeof(s.q[0]));
+    ep.p[0] = s.p[1];
+    ep.p[1] = s.p[0];
+
+    for(int i = 0; i < 16; ++i)
+      indices[i] = 15 - indices[i];
+  }
+
+  memset(out, 0, 16);
+  bit_writer w{out};
+
+  w.put(1 << 6, 7);
+  for(int c = 0; c < 4; ++c)
+  {
+    w.put(ep.q[0][c], 7);
+    w.put(ep.q[1][c], 7);
+  }
+  w.put(ep.p[0], 1);
+  w.put(ep.p[1], 1);
+
+  w.put(indices[0], 3);
+  for(int i = 1; i < 16; ++i)
+    w.put(indices[i], 4);
+}
+
+void decode_bc7_block(const uint8_t* in, uint8_t* rgba)
+{
+  if((in[0] & 0x7F) != 0x40)
+  {
+    for(int i = 0; i < 16; ++i)
+    {
+      rgba[i * 4 + 0] = 255;
+      rgba[i * 4 + 1] = 0;
+      rgba[i * 4 + 2] = 255;
+      rgba[i * 4 + 3] = 255;
+    }
+    return;
+  }
+
+  bit_reader r{in};
+  r.get(7);
+
+  int q[2][4];
+  for(int c = 0; c < 4; ++c)
+  {
+    q[0][c] = r.get(7);
+    q[1][c] = r.get(7);
+  }
+
+  int p0 = r.get(1);
+  int p1 = r.get(1);
+
+  for(int i = 0; i < 16; ++i)
+  {
+    int index = r.get(i == 0 ? 3 : 4);
+
+    for(int c = 0; c < 4; ++c)
+    {
+      int v0 = (q[0][c] << 1) | p0;
+      int v1 = (q[1][c] << 1) | p1;
+      rgba[i * 4 + c] = (uint8_t)(((64 - bc7_weights4[index]) * v0 + bc7_weights4[index] * v1 + 32) >> 6);
+    }
+  }
+}
+
+//
+// images
+//
+
+size_t bc1_size(int width, int height)
+{
+  return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 8;
+}
+
+size_t bc7_size(int width, int height)
+{
+  return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 16;
+}
+
+static void load_block(const uint8_t* rgba, int width, int height, int bx, int by, uint8_t* block)
+{
+  for(int y = 0; y < 4; ++y)
+  {
+    int sy = by * 4 + y < height ? by * 4 + y : height - 1;
+
+    for(int x = 0; x < 4; ++x)
+    {
+      int sx = bx * 4 + x < width ? bx * 4 + x : width - 1;
+      memcpy(block + (y * 4 + x) * 4, rgba + ((size_t)sy * width + sx) * 4, 4);
+    }
+  }
+}
+
+template <typename F>
+static void encode_blocks(const uint8_t* rgba, int width, int height, uint8_t* out, size_t block_bytes, const F& encode_block)
+{
+  int blocks_x = (width + 3) / 4;
+  int blocks_y = (height + 3) / 4;
+
+  jobs.parallel_for(blocks_y, 4, [&](size_t begin, size_t end) {
+    uint8_t block[64];
+
+    for(size_t by = begin; by < end; ++by)
+      for(int bx = 0; bx < blocks_x; ++bx)
+      {
+        load_block(rgba, width, height, bx, (int)by, block);
+        encode_block(block, out + (by * blocks_x + bx) * block_bytes);
+      }
+  });
+}
+
+void encode_bc1(const uint8_t* rgba, int width, int height, uint8_t* out, bc_quality quality)
+{
+  encode_blocks(rgba, width, height, out, 8, [quality](const uint8_t* block, uint8_t* dst) {
+    encode_bc1_block(block, dst, quality);
+  });
+}
+
+void encode_bc7(const uint8_t* rgba, int width, int height, uint8_t* out, bc_quality quality)
+{
+  encode_blocks(rgba, width, height, out, 16, [quality](const uint8_t* block, uint8_t* dst) {
+    encode_bc7_block(block, dst, quality);
+  });
+}
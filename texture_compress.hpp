@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// bc1 (opaque rgb, 8 bytes per 4x4 block) and bc7 (rgba, 16 bytes per
+// block) encoders for rgba8 images. every preset picks indices by exact
+// nearest palette entry, 16 pixels at a time with avx2. the presets differ
+// in how endpoints are found:
+//
+//   BC_FAST    bounding box endpoints, one pass
+//   BC_NORMAL  principal axis endpoints, one least squares refinement
+//   BC_HIGH    principal axis, three refinements, bc7 also searches p-bits
+//
+// bc7 only uses mode 6 (one subset, 7777 endpoints with p-bits, 4 bit
+// indices), which covers sprites with smooth alpha well at a fraction of
+// a full mode search.
+enum bc_quality
+{
+  BC_FAST,
+  BC_NORMAL,
+  BC_HIGH,
+};
+
+size_t bc1_size(int width, int height);
+size_t bc7_size(int width, int height);
+
+// one 4x4 block, `rgba` is 16 pixels in row order
+void encode_bc1_block(const uint8_t* rgba, uint8_t* out, bc_quality quality);
+void encode_bc7_block(const uint8_t* rgba, uint8_t* out, bc_quality quality);
+
+void decode_bc1_block(const uint8_t* in, uint8_t* rgba);
+void decode_bc7_block(const uint8_t* in, uint8_t* rgba); //mode 6 only, others decode to magenta
+
+// whole images, block rows spread over the job system. partial edge
+// blocks repeat the last row and column.
+void encode_bc1(const uint8_t* rgba, int width, int height, uint8_t* out, bc_quality quality);
+void encode_bc7(const uint8_t* rgba, int width, int height, uint8_t* out, bc_quality quality);
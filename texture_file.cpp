@@ -0,0 +1,238 @@
+#include "texture_file.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool texture_level_layout(uint32_t format, uint32_t width, uint32_t height, uint32_t& row_bytes, uint32_t& rows)
+{
+  switch(format)
+  {
+    case GL_RGBA8:
+      row_bytes = width * 4;
+      rows      = height;
+      return true;
+
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+      row_bytes = (width + 3) / 4 * 8;
+      rows      = (height + 3) / 4;
+      return true;
+
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+      row_bytes = (width + 3) / 4 * 16;
+      rows      = (height + 3) / 4;
+      return true;
+  }
+
+  return false;
+}
+
+int texture_block_height(uint32_t format)
+{
+  return format == GL_RGBA8 ? 1 : 4;
+}
+
+uint32_t pick_block_format(const unsigned char* rgba, int width, int height)
+{
+  for(size_t i = 0, n = (size_t)width * height; i < n; ++i)
+    if(rgba[i * 4 + 3] != 255)
+      return GL_COMPRESSED_RGBA_BPTC_UNORM;
+
+  return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+}
+
+void encode_levels(const unsigned char* rgba, int width, int height, bool mips, uint32_t format, bc_quality quality,
+                   std::vector<std::vector<unsigned char>>& levels, mip_filter filter)
+{
+  std::vector<std::vector<unsigned char>> chain;
+  if(mips)
+    build_mip_chain(rgba, width, height, chain, filter);
+
+  levels.clear();
+  levels.resize(chain.size() + 1);
+
+  int w = width, h = height;
+
+  for(size_t i = 0; i < levels.size(); ++i)
+  {
+    const unsigned char* src = i == 0 ? rgba : chain[i - 1].data();
+
+    switch(format)
+    {
+      case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        levels[i].resize(bc1_size(w, h));
+        encode_bc1(src, w, h, levels[i].data(), quality);
+        break;
+
+      case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        levels[i].resize(bc7_size(w, h));
+        encode_bc7(src, w, h, levels[i].data(), quality);
+        break;
+
+      default:
+        levels[i].assign(src, src + (size_t)w * h * 4);
+        break;
+    }
+
+    w = w > 1 ? w / 2 : 1;
+    h = h > 1 ? h / 2 : 1;
+  }
+}
+
+static size_t align_up(size_t v)
+{
+  return (v + texture_alignment - 1) / texture_alignment * texture_alignment;
+}
+
+bool cook_texture(const std::string& path, const unsigned char* rgba, int width, int height, bool mips,
+                  uint32_t format, bc_quality quality, mip_filter filter)
+{
+  uint32_t row_bytes, rows;
+  if(!texture_level_layout(format, 1, 1, row_bytes, rows))
+  {
+    fprintf(stderr, "ERROR: unknown texture format 0x%x\n", format);
+    return false;
+  }
+
+  std::vector<std::vector<unsigned char>> data;
+  encode_levels(rgba, width, height, mips, format, quality, data, filter);
+
+  texture_header header = {};
+  header.magic   = texture_magic;
+  header.version = texture_version;
+  header.format  = format;
+  header.width   = width;
+  header.height  = height;
+  header.levels  = data.size();
+
+  std::vector<texture_level> levels(data.size());
+  size_t offset = align_up(sizeof(header) + sizeof(texture_level) * levels.size());
+  uint32_t w = width, h = height;
+
+  for(texture_level& l : levels)
+  {
+    l.width  = w;
+    l.height = h;
+    texture_level_layout(header.format, w, h, l.row_bytes, l.rows);
+    l.size   = (uint64_t)l.row_bytes * l.rows;
+    l.offset = offset;
+    offset   = align_up(offset + l.size);
+
+    w = w > 1 ? w / 2 : 1;
+    h = h > 1 ? h / 2 : 1;
+  }
+
+  std::string tmp = path + ".tmp";
+  FILE* f = fopen(tmp.c_str(), "wb");
+
+  if(!f)
+  {
+    fprintf(stderr, "ERROR: failed to write %s\n", tmp.c_str());
+    return false;
+  }
+
+  static const unsigned char zeros[texture_alignment] = {};
+  bool ok = fwrite(&header, sizeof(header), 1, f) == 1
+         && fwrite(levels.data(), sizeof(texture_level), levels.size(), f) == levels.size();
+
+  size_t written = sizeof(header) + sizeof(texture_level) * levels.size();
+
+  for(size_t i = 0; i < levels.size() && ok; ++i)
+  {
+    ok = fwrite(zeros, 1, levels[i].offset - written, f) == levels[i].offset - written
+      && fwrite(data[i].data(), 1, levels[i].size, f) == levels[i].size;
+    written = levels[i].offset + levels[i].size;
+  }
+
+  ok &= fclose(f) == 0;
+
+  if(!ok || rename(tmp.c_str(), path.c_str()) != 0)
+  {
+    fprintf(stderr, "ERROR: failed to write %s\n", path.c_str());
+    remove(tmp.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+bool texture_file::open(const std::string& path)
+{
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if(fd < 0)
+    return false;
+
+  struct stat st;
+  if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(texture_header))
+  {
+    ::close(fd);
+    return false;
+  }
+
+  void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+
+  if(p == MAP_FAILED)
+    return false;
+
+  base   = (const unsigned char*)p;
+  size   = st.st_size;
+  header = (const texture_header*)base;
+  levels = (const texture_level*)(base + sizeof(texture_header));
+
+  //the size cap keeps row_bytes * rows inside 32 bits per dimension
+  bool ok = header->magic == texture_magic && header->version == texture_version
+         && header->width > 0 && header->height > 0
+         && header->width <= 65536 && header->height <= 65536
+         && header->levels > 0 && header->levels <= 32
+         && sizeof(texture_header) + sizeof(texture_level) * header->levels <= size;
+
+  //each level halves the one above, starting from the header size, and
+  //the chain ends at 1x1. that also keeps the level count within what
+  //glTextureStorage2D accepts for the size
+  uint32_t w = header->width, h = header->height;
+
+  for(uint32_t i = 0; ok && i < header->levels; ++i)
+  {
+    const texture_level& l = levels[i];
+    uint32_t row_bytes, rows;
+
+    if(i > 0)
+    {
+      ok = w > 1 || h > 1;
+      w  = w > 1 ? w / 2 : 1;
+      h  = h > 1 ? h / 2 : 1;
+    }
+
+    ok = ok && l.width == w && l.height == h
+      && texture_level_layout(header->format, l.width, l.height, row_bytes, rows)
+      && row_bytes == l.row_bytes && rows == l.rows
+      && l.size == (uint64_t)row_bytes * rows
+      && l.offset <= size && l.size <= size - l.offset;
+  }
+
+  if(!ok)
+  {
+    fprintf(stderr, "ERROR: %s is not a valid texture container\n", path.c_str());
+    close();
+    return false;
+  }
+
+  //the upload walks the levels front to back right after this
+  madvise(p, size, MADV_WILLNEED);
+  return true;
+}
+
+void texture_file::close()
+{
+  if(base)
+    munmap((void*)base, size);
+
+  base   = nullptr;
+  size   = 0;
+  header = nullptr;
+  levels = nullptr;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glad/gl.h>
+
+#include "mipmap.hpp"
+#include "texture_compress.hpp"
+
+//EXT_texture_compression_s3tc, not part of core
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+// cooked texture container, written offline by tools/texcook and mapped
+// read-only at runtime, so loading is an mmap and the upload copies
+// straight out of the page cache with nothing to inflate.
+//
+//   texture_header
+//   texture_level[levels]
+//   level data, each level starting on a texture_alignment boundary
+static const uint32_t texture_magic     = 0x58455447; //"GTEX"
+static const uint32_t texture_version   = 1;
+static const size_t   texture_alignment = 64;
+
+struct texture_header
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t format;   //GL_RGBA8, GL_COMPRESSED_RGB_S3TC_DXT1_EXT or GL_COMPRESSED_RGBA_BPTC_UNORM
+  uint32_t width;
+  uint32_t height;
+  uint32_t levels;
+  uint32_t reserved[2];
+};
+
+struct texture_level
+{
+  uint64_t offset;   //from the start of the file
+  uint64_t size;
+  uint32_t width;
+  uint32_t height;
+  uint32_t row_bytes;
+  uint32_t rows;     //rows of row_bytes, pixel rows or rows of 4x4 blocks
+};
+
+static_assert(sizeof(texture_header) == 32, "texture_header is part of the file format");
+static_assert(sizeof(texture_level) == 32, "texture_level is part of the file format");
+
+// row layout of one level in a given format, false for unknown formats.
+// block formats count rows of blocks, `block_height` pixels each
+bool texture_level_layout(uint32_t format, uint32_t width, uint32_t height, uint32_t& row_bytes, uint32_t& rows);
+int  texture_block_height(uint32_t format);
+
+// encodes rgba8 pixels and (optionally) their mip chain in `format` and
+// writes them through a temporary file renamed into place
+bool cook_texture(const std::string& path, const unsigned char* rgba, int width, int height, bool mips,
+                  uint32_t format = GL_RGBA8, bc_quality quality = BC_NORMAL, mip_filter filter = MIP_BOX);
+
+// bc1 when every pixel is opaque, bc7 otherwise
+uint32_t pick_block_format(const unsigned char* rgba, int width, int height);
+
+// level 0 and the mip chain in `format`, one buffer per level. this is
+// what cook_texture writes, and what asset_loader builds when it
+// compresses at load time
+void encode_levels(const unsigned char* rgba, int width, int height, bool mips, uint32_t format, bc_quality quality,
+                   std::vector<std::vector<unsigned char>>& levels, mip_filter filter = MIP_BOX);
+
+// a mapped container. every offset and size is checked against the file
+// on open, so the pointers handed out stay inside the mapping.
+struct texture_file
+{
+  bool open(const std::string& path);
+  void close();
+
+  const unsigned char* level_data(int level) const { return base + levels[level].offset; }
+
+  const unsigned char* base   = nullptr;
+  size_t               size   = 0;
+  const texture_header* header = nullptr;
+  const texture_level*  levels = nullptr;
+};
@@ -0,0 +1,97 @@
+// offline texture cooker: decodes images once and writes <image>.gtex
+// containers next to them, which asset_loader maps instead of decoding.
+// `auto` stores opaque images as bc1 and the rest as bc7, `kaiser` keeps
+// small levels sharper than the box filter.
+//
+//   g++ -std=c++17 -O2 -march=native -pthread -I. tools/texcook.cpp texture_file.cpp texture_compress.cpp mipmap.cpp jobs.cpp -limage -o texcook
+//   ./texcook [--no-mips] [--format auto|rgba8|bc1|bc7] [--quality fast|normal|high] [--mip-filter box|kaiser] bird64.png background.png ...
+
+#include <cstdio>
+#include <string>
+
+#include "jobs.hpp"
+#include "texture_file.hpp"
+
+extern "C" {
+  #include <image.h>
+}
+
+int main(int argc, char* argv[])
+{
+  bool        mips    = true;
+  std::string format  = "auto";
+  bc_quality  quality = BC_NORMAL;
+  mip_filter  filter  = MIP_BOX;
+  int         failed  = 0;
+
+  jobs.init();
+
+  for(int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+
+    if(arg == "--no-mips")
+    {
+      mips = false;
+      continue;
+    }
+
+    if(arg == "--format" && i + 1 < argc)
+    {
+      format = argv[++i];
+      continue;
+    }
+
+    if(arg == "--quality" && i + 1 < argc)
+    {
+      std::string q = argv[++i];
+      quality = q == "fast" ? BC_FAST : (q == "high" ? BC_HIGH : BC_NORMAL);
+      continue;
+    }
+
+    if(arg == "--mip-filter" && i + 1 < argc)
+    {
+      filter = std::string(argv[++i]) == "kaiser" ? MIP_KAISER : MIP_BOX;
+      continue;
+    }
+
+    Image img = {};
+    Image_load(&img, arg.c_str());
+
+    if(!img.data)
+    {
+      fprintf(stderr, "ERROR: failed to load %s\n", arg.c_str());
+      ++failed;
+      continue;
+    }
+
+    //the loader only cooks rgba8, same as the renderer uploads pngs
+    if(img.c != 4)
+    {
+      fprintf(stderr, "ERROR: %s has %d channels, only rgba is supported\n", arg.c_str(), img.c);
+      Image_free(&img);
+      ++failed;
+      continue;
+    }
+
+    uint32_t gl_format = GL_RGBA8;
+    if(format == "auto")
+      gl_format = pick_block_format(img.data, img.w, img.h);
+    else if(format == "bc1")
+      gl_format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    else if(format == "bc7")
+      gl_format = GL_COMPRESSED_RGBA_BPTC_UNORM;
+
+    const char* name = gl_format == GL_RGBA8 ? "rgba8" : (gl_format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? "bc1" : "bc7");
+
+    if(cook_texture(arg + ".gtex", img.data, img.w, img.h, mips, gl_format, quality, filter))
+      printf("%s.gtex  %dx%d %s%s\n", arg.c_str(), img.w, img.h, name, mips ? " + mips" : "");
+    else
+      ++failed;
+
+    Image_free(&img);
+  }
+
+  jobs.shutdown();
+  return failed != 0;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+
+// single producer / single consumer exchange of the latest value. the
+// writer fills its private slot and swaps it with the shared one, the
+// reader swaps the shared slot in only if something new was published.
+// neither side ever waits on the other, the reader may just see the same
+// value twice or skip intermediate ones.
+template <typename T>
+struct triple_buffer
+{
+  // bit 2 of `shared` marks an unread slot
+  static const unsigned int fresh_bit = 4;
+
+  T& write_slot()
+  {
+    return slots[back];
+  }
+
+  void publish()
+  {
+    unsigned int prev = shared.exchange(back | fresh_bit, std::memory_order_acq_rel);
+    back = prev & 3;
+  }
+
+  // returns true when the slot behind read_slot() changed
+  bool acquire()
+  {
+    if(!(shared.load(std::memory_order_relaxed) & fresh_bit))
+      return false;
+
+    unsigned int prev = shared.exchange(front, std::memory_order_acq_rel);
+    front = prev & 3;
+    return true;
+  }
+
+  const T& read_slot() const
+  {
+    return slots[front];
+  }
+
+  T slots[3];
+  std::atomic<unsigned int> shared{1};
+  unsigned int back  = 0; //writer only
+  unsigned int front = 2; //reader only
+};
@@ -0,0 +1,76 @@
+#include "uniforms.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+static size_t align_up(size_t size, size_t alignment)
+{
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+bool uniform_system::create()
+{
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+  view_stride = align_up(sizeof(view_uniforms), alignment);
+
+  glCreateBuffers(1, &view_buffer);
+  glNamedBufferStorage(view_buffer, view_stride * max_views, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+  //version 0 is never handed out, versions are unique across cameras
+  memset(view_versions, 0, sizeof(view_versions));
+
+  return frame_buffer.create(align_up(sizeof(frame_uniforms), alignment));
+}
+
+void uniform_system::destroy()
+{
+  frame_buffer.destroy();
+  glDeleteBuffers(1, &view_buffer);
+  view_buffer = 0;
+}
+
+void uniform_system::upload_frame(const frame_uniforms& frame)
+{
+  frame_buffer.begin_frame();
+
+  void* ptr = nullptr;
+  size_t offset = frame_buffer.alloc(sizeof(frame_uniforms), alignment, &ptr);
+  memcpy(ptr, &frame, sizeof(frame_uniforms));
+
+  glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, frame_buffer.id, offset, sizeof(frame_uniforms));
+}
+
+void uniform_system::end_frame()
+{
+  frame_buffer.end_frame();
+}
+
+bool uniform_system::sync_view(int slot, camera& cam)
+{
+  if(slot < 0 || slot >= max_views)
+  {
+    fprintf(stderr, "ERROR: view slot %d out of range\n", slot);
+    return false;
+  }
+
+  if(!cam.changed_since(view_versions[slot]))
+    return false;
+
+  view_uniforms data;
+  data.mvp        = cam.mvp();
+  data.view       = cam.view;
+  data.projection = cam.projection;
+  data.viewport   = glm::vec4(cam.vp.x, cam.vp.y, cam.vp.w, cam.vp.h);
+
+  glNamedBufferSubData(view_buffer, view_stride * slot, sizeof(view_uniforms), &data);
+  return true;
+}
+
+void uniform_system::bind_view(int slot)
+{
+  if(slot < 0 || slot >= max_views)
+    return;
+
+  glBindBufferRange(GL_UNIFORM_BUFFER, VIEW_BLOCK_BINDING, view_buffer, view_stride * slot, sizeof(view_uniforms));
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "camera.hpp"
+#include "stream_buffer.hpp"
+
+// fixed binding points shared by every program, they must match the
+// layout(binding = N) qualifiers of the blocks declared in shaders/
+enum block_binding : unsigned int
+{
+  FRAME_BLOCK_BINDING = 0,
+  VIEW_BLOCK_BINDING  = 1,
+};
+
+// std140 mirror of frame_block
+struct frame_uniforms
+{
+  glm::vec2 resolution;
+  float     time;
+  float     dt;
+};
+
+// std140 mirror of view_block
+struct view_uniforms
+{
+  glm::mat4 mvp;
+  glm::mat4 view;
+  glm::mat4 projection;
+  glm::vec4 viewport; // x, y, w, h in pixels
+};
+
+static_assert(sizeof(frame_uniforms) % 16 == 0, "frame_uniforms must be std140 sized");
+static_assert(sizeof(view_uniforms)  % 16 == 0, "view_uniforms must be std140 sized");
+
+// the frame block changes every frame and is written into a stream_buffer
+// region. view blocks live in fixed slots of a separate buffer and are only
+// rewritten when their camera changed. everything is bound with
+// glBindBufferRange, so adding programs or passes costs a bind per view
+// instead of a glUniform* call per uniform per program.
+struct uniform_system
+{
+  static const int max_views = 8;
+
+  bool create();
+  void destroy();
+
+  //call once per frame, before any draw that reads the blocks
+  void upload_frame(const frame_uniforms& frame);
+  void end_frame();
+
+  //rewrites the slot only if `cam` changed since the last sync of that slot,
+  //or the slot was last synced from another camera. returns true when an
+  //upload happened
+  bool sync_view(int slot, camera& cam);
+  void bind_view(int slot);
+
+  stream_buffer frame_buffer;
+  unsigned int  view_buffer = 0;
+  int    alignment = 256;
+  size_t view_stride = 0;
+  unsigned int view_versions[max_views] = {};
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <glad/gl.h>
+
+#include "quantize.hpp"
+
+// vertex and instance structs are built from attrib<> members, which carry
+// the component type, count and how the shader sees them. VERTEX_LAYOUT()
+// turns the member list into a constexpr table of gl formats and offsets,
+// and setup_vertex_layout() replays it on a vao. nothing is looked up at
+// runtime and the table cannot drift from the struct.
+
+enum class attrib_kind
+{
+  FLOAT,      //converted to float as is
+  NORMALIZED, //integer mapped to [0, 1] or [-1, 1]
+  INTEGER,    //stays integer, read with ivec/uvec in the shader
+};
+
+template <typename T, int N, attrib_kind K = attrib_kind::FLOAT>
+struct attrib
+{
+  typedef T component;
+  static const int         count = N;
+  static const attrib_kind kind  = K;
+
+  T v[N];
+
+  T&       operator[](int i)       { return v[i]; }
+  const T& operator[](int i) const { return v[i]; }
+};
+
+template <typename T> struct gl_component;
+template <> struct gl_component<float>    { static constexpr GLenum type = GL_FLOAT; };
+template <> struct gl_component<half>     { static constexpr GLenum type = GL_HALF_FLOAT; };
+template <> struct gl_component<int8_t>   { static constexpr GLenum type = GL_BYTE; };
+template <> struct gl_component<uint8_t>  { static constexpr GLenum type = GL_UNSIGNED_BYTE; };
+template <> struct gl_component<int16_t>  { static constexpr GLenum type = GL_SHORT; };
+template <> struct gl_component<uint16_t> { static constexpr GLenum type = GL_UNSIGNED_SHORT; };
+template <> struct gl_component<int32_t>  { static constexpr GLenum type = GL_INT; };
+template <> struct gl_component<uint32_t> { static constexpr GLenum type = GL_UNSIGNED_INT; };
+
+struct attrib_desc
+{
+  GLint     count;
+  GLenum    type;
+  GLboolean normalized;
+  bool      integer;
+  GLuint    offset;
+  GLuint    size;
+};
+
+template <typename A>
+constexpr attrib_desc describe_attrib(size_t offset)
+{
+  static_assert(A::kind != attrib_kind::NORMALIZED || !std::is_same<typename A::component, float>::value, "floats cannot be normalised");
+  static_assert(A::kind != attrib_kind::NORMALIZED || !std::is_same<typename A::component, half>::value, "halfs cannot be normalised");
+  static_assert(A::count >= 1 && A::count <= 4, "an attribute has 1 to 4 components");
+  static_assert(sizeof(A) == sizeof(typename A::component) * A::count, "attrib must be tightly packed");
+
+  return {
+    A::count,
+    gl_component<typename A::component>::type,
+    A::kind == attrib_kind::NORMALIZED ? (GLboolean)GL_TRUE : (GLboolean)GL_FALSE,
+    A::kind == attrib_kind::INTEGER,
+    (GLuint)offset,
+    (GLuint)sizeof(A),
+  };
+}
+
+template <typename S>
+struct vertex_layout; //specialised by VERTEX_LAYOUT
+
+#define VERTEX_LAYOUT_ATTRIB(S, m) describe_attrib<decltype(S::m)>(offsetof(S, m))
+
+#define VERTEX_LAYOUT_1(S, a)      VERTEX_LAYOUT_ATTRIB(S, a)
+#define VERTEX_LAYOUT_2(S, a, ...) VERTEX_LAYOUT_ATTRIB(S, a), VERTEX_LAYOUT_1(S, __VA_ARGS__)
+#define VERTEX_LAYOUT_3(S, a, ...) VERTEX_LAYOUT_ATTRIB(S, a), VERTEX_LAYOUT_2(S, __VA_ARGS__)
+#define VERTEX_LAYOUT_4(S, a, ...) VERTEX_LAYOUT_ATTRIB(S, a), VERTEX_LAYOUT_3(S, __VA_ARGS__)
+#define VERTEX_LAYOUT_5(S, a, ...) VERTEX_LAYOUT_ATTRIB(S, a), VERTEX_LAYOUT_4(S, __VA_ARGS__)
+#define VERTEX_LAYOUT_6(S, a, ...) VERTEX_LAYOUT_ATTRIB(S, a), VERTEX_LAYOUT_5(S, __VA_ARGS__)
+#define VERTEX_LAYOUT_7(S, a, ...) VERTEX_LAYOUT_ATTRIB(S, a), VERTEX_LAYOUT_6(S, __VA_ARGS__)
+#define VERTEX_LAYOUT_8(S, a, ...) VERTEX_LAYOUT_ATTRIB(S, a), VERTEX_LAYOUT_7(S, __VA_ARGS__)
+
+#define VERTEX_LAYOUT_PICK(_1, _2, _3, _4, _5, _6, _7, _8, NAME, ...) NAME
+#define VERTEX_LAYOUT_LIST(S, ...) \
+  VERTEX_LAYOUT_PICK(__VA_ARGS__, VERTEX_LAYOUT_8, VERTEX_LAYOUT_7, VERTEX_LAYOUT_6, VERTEX_LAYOUT_5, \
+                     VERTEX_LAYOUT_4, VERTEX_LAYOUT_3, VERTEX_LAYOUT_2, VERTEX_LAYOUT_1, )(S, __VA_ARGS__)
+
+// members are assigned consecutive locations in the order they are listed
+#define VERTEX_LAYOUT(S, ...)                                                      \
+  template <>                                                                      \
+  struct vertex_layout<S>                                                          \
+  {                                                                                \
+    static_assert(std::is_standard_layout<S>::value, #S " must be standard layout"); \
+    static constexpr attrib_desc attribs[] = { VERTEX_LAYOUT_LIST(S, __VA_ARGS__) }; \
+    static constexpr int     count  = sizeof(attribs) / sizeof(attribs[0]);        \
+    static constexpr GLsizei stride = sizeof(S);                                   \
+  }
+
+template <typename S>
+constexpr bool vertex_layout_fits()
+{
+  for(int i = 0; i < vertex_layout<S>::count; ++i)
+  {
+    const attrib_desc& a = vertex_layout<S>::attribs[i];
+    if(a.offset + a.size > sizeof(S))
+      return false;
+  }
+  return true;
+}
+
+// formats locations [first_location, first_location + count) of `vao` from
+// S and sources them from `binding`. divisor 1 makes S a per-instance struct.
+template <typename S>
+void setup_vertex_layout(unsigned int vao, unsigned int binding, unsigned int first_location, unsigned int divisor = 0)
+{
+  static_assert(vertex_layout_fits<S>(), "attribute runs past the end of the struct");
+
+  for(int i = 0; i < vertex_layout<S>::count; ++i)
+  {
+    const attrib_desc& a = vertex_layout<S>::attribs[i];
+    unsigned int location = first_location + i;
+
+    glEnableVertexArrayAttrib(vao, location);
+
+    if(a.integer)
+      glVertexArrayAttribIFormat(vao, location, a.count, a.type, a.offset);
+    else
+      glVertexArrayAttribFormat(vao, location, a.count, a.type, a.normalized, a.offset);
+
+    glVertexArrayAttribBinding(vao, location, binding);
+  }
+
+  glVertexArrayBindingDivisor(vao, binding, divisor);
+}
+
+// attaches `buffer` to `binding` with the stride of S
+template <typename S>
+void bind_vertex_buffer(unsigned int vao, unsigned int binding, unsigned int buffer, GLintptr offset)
+{
+  glVertexArrayVertexBuffer(vao, binding, buffer, offset, vertex_layout<S>::stride);
+}